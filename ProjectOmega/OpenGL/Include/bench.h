@@ -0,0 +1,58 @@
+#ifndef BENCH_H
+#define BENCH_H
+
+#include <glad/glad.h>
+#include <string>
+#include <vector>
+#include <scene.h>
+#include <resolution.h>
+
+#define BENCH_ERROR_FRAMES 8		// frames along the camera path --match-error compares
+
+struct BenchOptions {
+	int frames = 600;
+	int warmup = 30;
+	GLsizei width = 1000, height = 1000;
+	GLfloat blurRadius = 0.f;
+	GLfloat renderScale = 1.f;	// offscreen targets relative to width x height
+	GLfloat budgetMs = 0.f;		// GPU frame time for the dynamic resolution, 0 keeps renderScale
+	int framesInFlight = FRAME_CONTEXTS;
+	GLfloat refractScale = REFRACT_SCALE;
+	bool refractCull = true;	// off: full refraction target every frame, for comparison
+	bool waterGrid = true;		// off: the water from its vertex buffer
+	int waterResolution = WATER_RESOLUTION;	// 0: the finest the fixed grid needs over the run to keep within lodPixels
+	int waterLod = -1;			// WATER_LOD_*, -1 leaves the scene's choice
+	GLfloat lodPixels = WATER_LOD_PIXELS;
+	GLfloat matchError = 0.f;	// > 0: search each water LOD for this mean error instead of the timed run
+	int waterSim = WATER_SIM_SIZE;	// heightfield texels a side
+	int oceanSize = OCEAN_SIZE;		// FFT size of the ocean style
+	bool oceanGpu = false;		// the ocean's transforms in fragment passes instead of on the worker pool
+	int causticsGrid = CAUSTICS_GRID;	// quads per side of the caustics' light grid
+	int causticsSize = CAUSTICS_SIZE;	// caustics texels a side
+	bool compute = true;		// off: fragment blur and gather even where compute shaders are available, for comparison
+	GLfloat fNumber = DOF_F_NUMBER;
+	bool autofocus = false;
+	GLfloat focusRegion[4] = { 0.f, 0.f, 0.f, 0.f };	// x, y, width, height; zero width keeps the default
+	bool blurDof = false, legacyBlur = false, measureBlur = false;
+	bool cpu = false;		// time the CPU-side building blocks instead of rendering
+	int style = WATER_SIM_STYLE, selection = 3;
+	std::string output = "bench_stats.csv";
+	std::string dump;		// PPM file for the last combined frame
+	int usage = -1;			// exit code once the usage is printed (0 for --help, 1 for a bad argument), -1 to go on
+};
+
+// returns true if --bench or --cpu was given
+bool parseBenchArgs(int argc, char ** argv, BenchOptions & o);
+FrameParams benchFrame(const BenchOptions & o, int frame);
+
+// GL 3.3 core context without a visible window (EGL when built with OMEGA_EGL, otherwise a hidden GLFW window)
+bool createOffscreenContext(const BenchOptions & o);
+// the color attachment of fbo as bottom-up rows of 8-bit RGB
+std::vector<unsigned char> readFramebuffer(GLuint fbo, GLsizei width, GLsizei height);
+void dumpFramebuffer(GLuint fbo, GLsizei width, GLsizei height, const std::string & path);
+double percentile(std::vector<double> sorted, double p);
+
+int runBenchmark(const BenchOptions & o);
+int runCpuBenchmark(const BenchOptions & o);
+
+#endif
@@ -0,0 +1,65 @@
+#ifndef BLUR_H
+#define BLUR_H
+
+#include <glad/glad.h>
+#include <cmath>
+#include <vector>
+
+// maximum number of bilinear taps on each side of the center tap (must match gauss.fsh)
+#define BLUR_MAX_TAPS 8
+// work group size of gauss.csh in each direction (must match)
+#define BLUR_COMPUTE_TILE 16
+
+struct BlurPyramid {
+	/*
+	Downsampled separable gaussian blur
+	The source is box-downsampled into a chain of half-resolution levels, the smallest level is blurred
+	with a horizontal and a vertical pass (two texels per fetch using bilinear filtering), then the result
+	is bilinearly upsampled back up the chain. output is the texture that holds the final blur.
+	With compute set and a context that has compute shaders, both gaussian passes are one dispatch of
+	gauss.csh instead: each work group reads its tile plus the kernel radius around it into shared memory
+	once and filters it there, so the scratch target only holds the last downsample
+	*/
+	GLuint resampleprogram = 0, gaussprogram = 0, computeprogram = 0;
+	GLint r_src = -1, g_src = -1, g_direction = -1, g_taps = -1, g_weights = -1, g_offsets = -1;
+	GLint k_src = -1, k_radius = -1, k_kernel = -1;
+	bool compute = true;
+
+	GLsizei width = 0, height = 0;	// resolution of the source image
+	GLfloat radius = 0.f;			// target gaussian sigma in source pixels
+	int levels = 0;					// number of half-resolution steps before blurring
+
+	std::vector<GLuint> fbo, tex;	// level i is width >> i by height >> i (level 0 only exists when levels == 0)
+	GLuint scratchFbo = 0, scratchTex = 0;	// horizontal pass target at the blurred level
+
+	int taps = 0;					// bilinear taps on each side of the center
+	GLfloat weights[BLUR_MAX_TAPS + 1], offsets[BLUR_MAX_TAPS + 1];
+	int support = 0;				// texels on each side of the center, for the compute path
+	GLfloat kernel[2 * BLUR_MAX_TAPS + 1];
+
+	GLuint output = 0;
+	GLsizei outWidth = 0, outHeight = 0;
+};
+
+struct BlurError {
+	GLfloat mean, max;	// absolute difference per channel, in 8-bit steps
+};
+
+// gaussian sigma (pixels) that passes rounds of the legacy 3x3 ping-pong blur converge to
+GLfloat legacyBlurSigma(int passes, GLfloat offset);
+
+// RGBA8 color target with linear filtering
+void makeBlurTarget(GLuint * fbo, GLuint * tex, GLsizei w, GLsizei h);
+
+void setupBlurPyramid(BlurPyramid & b, GLsizei width, GLsizei height, GLfloat radius);
+void releaseBlurPyramid(BlurPyramid & b);
+void runBlurPyramid(BlurPyramid & b, GLuint source, GLuint screenVAO);
+// true if runBlurPyramid takes the compute path
+bool blurPyramidCompute(const BlurPyramid & b);
+
+// texture fetches per full-resolution pixel
+GLfloat blurPyramidFetches(const BlurPyramid & b);
+// mean/max difference against a full-resolution reference; reads back, so only call on demand
+BlurError measureBlurError(const BlurPyramid & b, GLuint reference);
+
+#endif
@@ -0,0 +1,41 @@
+#ifndef CAUSTICS_H
+#define CAUSTICS_H
+
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+
+#define CAUSTICS_SIZE 256				// texels a side of the caustics on the pool floor
+#define CAUSTICS_SIZE_MAX 1024
+#define CAUSTICS_GRID 128				// quads per side of the light's grid over the water
+#define CAUSTICS_GRID_MAX 1024
+#define CAUSTICS_UNIT 9					// texture unit the pool reads the caustics from
+
+struct Caustics {
+	/*
+	Light focused by the water onto the pool floor, recomputed from the drawn surface every frame
+	A grid of parallel light rays, one per vertex over the water (the light's orthographic view of it),
+	is refracted at the displaced surface and followed to the floor plane, where the grid is rasterized
+	into an R16F texture over the floor's x, z with additive blending. Each fragment adds the area its
+	triangle had landing through still water over the area it lands on, so still water lights the floor
+	evenly at 1 and the energy of a ray bundle is kept wherever the waves focus or spread it.
+	The cost is the grid and the texture, both fixed: grid x grid quads and size x size texels per frame
+	whatever the camera sees. The grid is free to change between frames, one finer than the texture only
+	adds triangles smaller than a texel
+	*/
+	GLsizei size = 0;
+	GLuint grid = CAUSTICS_GRID;
+	glm::vec4 rect = glm::vec4(0.f, 0.f, 1.f, 1.f);	// x, z of the corner of the floor the texture covers and its size along x, z
+	GLfloat floor = 0.f;			// height of the floor
+
+	GLuint fbo = 0, texture = 0;
+};
+
+// (re)allocates a size x size caustics texture over the floor rect (see Caustics::rect) at height floor
+void setupCaustics(Caustics & c, GLsizei size, glm::vec4 rect, GLfloat floor);
+void releaseCaustics(Caustics & c);
+
+// draws the grid with the bound program (caustics.vsh for the water's style, the WaterGrid block bound with
+// c.grid quads a side) and leaves the texture bound to CAUSTICS_UNIT and the viewport at its size
+void runCaustics(Caustics & c, GLuint gridVAO);
+
+#endif
@@ -0,0 +1,103 @@
+#ifndef DOF_H
+#define DOF_H
+
+#include <glad/glad.h>
+#include <vector>
+
+#define DOF_TILE 16					// tile size in pixels, also the largest circle of confusion radius (must match dof*.fsh)
+#define DOF_TAPS 32					// gather taps per blurred pixel
+#define DOF_COMPUTE_GROUP 16		// half-resolution pixels a side per work group of dofgather.csh (must match)
+#define DOF_F_NUMBER 1.4f			// aperture
+#define DOF_SENSOR_HEIGHT 0.024f	// scene units (meters) of a 35mm frame; with the field of view this fixes the focal length
+#define DOF_COC_UNIT 10				// texture unit of the color + circle of confusion target
+#define DOF_TILE_UNIT 11			// texture unit of the tile map
+#define DOF_FOCUS_UNIT 12			// texture unit of the autofocus result
+#define AUTOFOCUS_SAMPLES 32		// the focus region is resampled to this many texels a side, then mip-reduced to one
+#define AUTOFOCUS_TIME 0.25f		// seconds for the focus to close 63% of the distance to a new target
+#define AUTOFOCUS_READBACK 3		// pixel pack buffers in flight for the optional readback
+
+struct DepthOfField {
+	/*
+	Thin-lens depth of field
+	The CoC pass linearizes depth and stores color plus a signed circle of confusion radius (negative in
+	front of the focus distance, which comes from PerFrame.focus), mapped from -DOF_TILE..DOF_TILE pixels
+	to 0..1 so an RGBA8 target holds it in eighth pixel steps. The tile pass reduces it to the largest
+	radius per DOF_TILE x DOF_TILE tile and the dilate pass takes the max over the 3x3 neighbouring tiles,
+	so a tile knows every blur that can reach into it. Tiles whose radius is under half a pixel skip all
+	blur work. Elsewhere the gather pass takes DOF_TAPS taps of a disc, weighted scatter-as-gather by each
+	tap's own CoC, at half resolution, and the final full-resolution pass mixes it with the sharp color
+	by CoC; or the final pass mixes in an externally blurred image instead (blend, the look of the old
+	combine pass)
+	With compute set and a context that has compute shaders, the gather is dofgather.csh: a work group of
+	half-resolution pixels covers 2x2 tiles, takes the largest radius among them, reads the CoC texels its
+	taps can reach into shared memory once and filters them from there (a sharp group reads nothing)
+	*/
+	GLuint cocprogram = 0, tileprogram = 0, dilateprogram = 0, gatherprogram = 0, compositeprogram = 0, blendprogram = 0;
+	GLuint gathercompute = 0;
+	GLint c_color = -1, c_depth = -1, c_lens = -1, c_focus = -1, c_autofocus = -1;
+	GLint t_coc = -1, d_tiles = -1;
+	GLint g_coc = -1, g_tiles = -1, g_taps = -1;
+	GLint k_coc = -1, k_tiles = -1, k_taps = -1;
+	bool compute = true;
+	GLint m_coc = -1, m_tiles = -1, m_gathered = -1;
+	GLint b_coc = -1, b_tiles = -1, b_blurred = -1;
+
+	GLsizei width = 0, height = 0;
+	GLsizei tilesX = 0, tilesY = 0;
+	GLsizei halfWidth = 0, halfHeight = 0;
+	GLfloat fNumber = DOF_F_NUMBER;
+	GLfloat focalLength = 0.f;		// scene units
+	GLfloat lensScale = 0.f;		// CoC radius in pixels = lensScale * |d - focus| / (d * (focus - focalLength))
+
+	GLuint cocFbo = 0, cocTex = 0;
+	GLuint tileFbo[2] = { 0, 0 }, tileTex[2] = { 0, 0 };	// per-tile max, then dilated
+	GLuint halfFbo = 0, halfTex = 0;		// gathered color, alpha is how much foreground covers the pixel
+	GLuint fbo = 0, output = 0;
+};
+
+// (re)allocates the targets for a width x height image seen with a vertical field of view of fovy degrees
+void setupDepthOfField(DepthOfField & d, GLsizei width, GLsizei height, GLfloat fovy);
+void releaseDepthOfField(DepthOfField & d);
+// color and depth are width x height; blurred (0 to gather) is mixed in by CoC instead of gathering;
+// the focus distance comes from the 1x1 focus texture, or from PerFrame.focus if that is 0
+// expects depth testing to be disabled and the PerFrame block bound; leaves the viewport at full size
+void runDepthOfField(DepthOfField & d, GLuint color, GLuint depth, GLuint blurred, GLuint focus, GLuint screenVAO);
+
+// fraction of tiles that skipped the blur in the last run; reads back, so only call on demand
+GLfloat dofSharpTiles(const DepthOfField & d);
+
+struct Autofocus {
+	/*
+	Focus distance measured on the GPU and kept there
+	The sample pass resamples the depth buffer under region to AUTOFOCUS_SAMPLES^2 inverse distances and
+	the mip chain averages them down to one texel (averaging 1/d keeps the sky from dragging the focus
+	away). The smooth pass eases the 1x1 result towards that average, ping-ponging between two textures,
+	and the depth of field reads it from there, so nothing waits on the CPU.
+	With readback set, the result is also copied into a ring of pixel pack buffers and read only once its
+	fence has passed, for logging
+	*/
+	GLuint sampleprogram = 0, smoothprogram = 0;
+	GLint s_depth = -1, s_region = -1;
+	GLint m_samples = -1, m_history = -1, m_rate = -1, m_level = -1;
+
+	GLfloat region[4] = { 0.4f, 0.4f, 0.2f, 0.2f };	// x, y, width, height as fractions of the screen
+	GLfloat lastTime = -1.f;
+
+	GLuint sampleFbo = 0, sampleTex = 0;
+	GLuint fbo[2] = { 0, 0 }, tex[2] = { 0, 0 };
+	int current = 0;				// tex[current] holds the latest focus distance
+	GLuint output = 0;
+
+	bool readback = false;
+	GLuint pbo[AUTOFOCUS_READBACK];
+	GLsync fences[AUTOFOCUS_READBACK];
+	int next = 0;
+	GLfloat focus = 0.f;			// last value read back, a few frames old; 0 before the first one
+	unsigned reads = 0, misses = 0;	// readbacks done and skipped because the GPU was not there yet
+};
+
+void setupAutofocus(Autofocus & a);
+// measures depth (the scene's depth texture) at the given time in seconds; expects the PerFrame block bound
+void runAutofocus(Autofocus & a, GLuint depth, GLfloat time, GLuint screenVAO);
+
+#endif
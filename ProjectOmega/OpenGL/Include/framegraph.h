@@ -0,0 +1,94 @@
+#ifndef FRAMEGRAPH_H
+#define FRAMEGRAPH_H
+
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+#include <functional>
+#include <map>
+#include <string>
+#include <utility>
+#include <vector>
+#include <profiler.h>
+
+struct FrameTextureDesc {
+	GLsizei width = 0, height = 0;
+	GLenum internalFormat = GL_RGBA8;	// GL_RGBA8, GL_RGBA16F, GL_R16F, GL_R32F or GL_DEPTH_COMPONENT24
+	GLint filter = GL_LINEAR;
+	bool operator==(const FrameTextureDesc & o) const {
+		return width == o.width && height == o.height && internalFormat == o.internalFormat && filter == o.filter;
+	}
+};
+
+struct FrameResource {
+	std::string name;
+	FrameTextureDesc desc;
+	bool imported = false;		// owned outside the graph (module targets, the output framebuffer)
+	GLuint texture = 0;			// the imported texture, or the pooled one compileFrameGraph picked
+	bool output = false;		// an imported framebuffer (fbo, 0 for the window): passes writing it always run
+	GLuint fbo = 0;
+	int first = -1, last = -1;	// first and last pass that uses it, -1 if no pass that runs does
+	int slot = -1;				// pool entry of a transient texture
+};
+
+struct FramePass {
+	std::string name;
+	std::vector<int> reads, writes;
+	int color = -1, depth = -1;		// target the graph binds (and clears) before execute; none: the pass binds its own
+	GLbitfield clear = 0;
+	glm::vec4 clearColor = glm::vec4(0.f);
+	bool sideEffect = false;		// runs even if nothing reads what it writes
+	int profile = -1;				// profiler pass that times it
+	std::function<void()> execute;
+
+	bool culled = false;
+	GLuint fbo = 0;
+	GLsizei width = 0, height = 0;
+};
+
+struct FramePoolTexture {
+	FrameTextureDesc desc;
+	GLuint texture = 0;
+	int busyUntil = -1;			// last pass of the resource using it in the current schedule
+};
+
+struct FrameGraph {
+	/*
+	Declarative schedule of the frame's passes
+	Passes are declared in execution order with the resources they read and write. Compiling culls every
+	pass whose writes no kept pass reads (passes that write an imported framebuffer or have sideEffect set
+	are always kept), computes each transient texture's lifetime over the kept passes and gives resources
+	with the same description and disjoint lifetimes the same pooled texture. Executing binds each pass's
+	target, sets the viewport and clears as declared, then runs it.
+	An aliased texture starts with whatever its last user left, so a pass must clear or fully overwrite
+	the transient targets it writes.
+	The pool and the framebuffers survive a rebuild, so recompiling an unchanged graph allocates nothing.
+	*/
+	std::vector<FrameResource> resources;
+	std::vector<FramePass> passes;
+	std::vector<FramePoolTexture> pool;
+	std::map<std::pair<GLuint, GLuint>, GLuint> fbos;	// framebuffer per (color, depth) texture pair
+
+	size_t bytes = 0, unaliasedBytes = 0;				// pooled texture memory, and what it would take unaliased
+	int culled = 0;
+};
+
+// drops the passes and resources, keeping the pool and framebuffers for the next compile
+void resetFrameGraph(FrameGraph & g);
+void releaseFrameGraph(FrameGraph & g);
+
+// resource ids, valid until the next reset
+int addFrameTexture(FrameGraph & g, const std::string & name, const FrameTextureDesc & desc);
+int importFrameTexture(FrameGraph & g, const std::string & name, GLuint texture);
+int importFramebuffer(FrameGraph & g, const std::string & name, GLuint fbo, GLsizei width, GLsizei height);
+// the returned reference is only valid until the next pass is added
+FramePass & addFramePass(FrameGraph & g, const std::string & name, const std::vector<int> & reads, const std::vector<int> & writes, std::function<void()> execute);
+
+// returns false if a framebuffer is incomplete
+bool compileFrameGraph(FrameGraph & g);
+void executeFrameGraph(FrameGraph & g, Profiler & p);
+
+GLuint frameTexture(const FrameGraph & g, int resource);
+// framebuffer with the given resources attached (depth -1 for none), made on first use; also for passes that bind their own targets
+GLuint frameFramebuffer(FrameGraph & g, int color, int depth = -1);
+
+#endif
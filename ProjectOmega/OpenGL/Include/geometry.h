@@ -0,0 +1,64 @@
+#ifndef GEOMETRY_H
+#define GEOMETRY_H
+
+#include <glad/glad.h>
+#include <vector>
+#include <glm/glm.hpp>
+
+struct Vertex {
+	GLfloat
+		x, y, z, // position
+		x1, y1, z1; // normal
+};
+
+struct NewVertex {
+	GLfloat
+		x, y, z, // position
+		x1, y1, z1, // normal
+		u, v; // texture
+};
+
+// triangle strips, consecutive rows and faces joined by degenerate triangles
+std::vector<Vertex> genPlane(glm::vec3 u, glm::vec3 v, const glm::vec3& start, const GLuint resolution);
+std::vector<Vertex> genCube(const GLfloat size, const unsigned int resolution, const glm::vec3 & offset = glm::vec3(0));
+std::vector<Vertex> genSphere(GLfloat radius, GLuint resolution, const glm::vec3 & offset = glm::vec3(0));
+
+//================================== with texture ========================================
+
+std::vector<NewVertex> genTexPlane(glm::vec3 u, glm::vec3 v, const glm::vec3 & start, const GLuint resolution);
+std::vector<NewVertex> genTexCube(const GLfloat size, const unsigned int resolution, const glm::vec3 & offset = glm::vec3(0));
+
+//================================== indexed ========================================
+
+#define VERTEX_CACHE_SIZE 32	// post-transform cache entries assumed by optimizeVertexCache and cacheStats
+
+template <typename V>
+struct IndexedMesh {
+	/*
+	Shared vertices plus a GL_TRIANGLES index list, same winding as the strips above
+	*/
+	std::vector<V> vertices;
+	std::vector<GLuint> indices;
+	GLenum indexType = GL_UNSIGNED_INT;	// set by uploadIndices
+};
+
+struct CacheStats {
+	GLfloat acmr;	// vertex shader runs per triangle (0.5 is the limit for a grid)
+	GLfloat atvr;	// vertex shader runs per unique vertex (1 is ideal)
+};
+
+// grids of (resolution + 1)^2 vertices, triangles reordered with optimizeVertexCache
+IndexedMesh<Vertex> genIndexedPlane(glm::vec3 u, glm::vec3 v, const glm::vec3 & start, const GLuint resolution);
+IndexedMesh<Vertex> genIndexedCube(const GLfloat size, const unsigned int resolution, const glm::vec3 & offset = glm::vec3(0));
+IndexedMesh<Vertex> genIndexedSphere(GLfloat radius, GLuint resolution, const glm::vec3 & offset = glm::vec3(0));
+IndexedMesh<NewVertex> genIndexedTexPlane(glm::vec3 u, glm::vec3 v, const glm::vec3 & start, const GLuint resolution);
+IndexedMesh<NewVertex> genIndexedTexCube(const GLfloat size, const unsigned int resolution, const glm::vec3 & offset = glm::vec3(0));
+
+// reorders triangles for the post-transform cache (Forsyth, "Linear-Speed Vertex Cache Optimisation")
+void optimizeVertexCache(std::vector<GLuint> & indices, size_t vertexCount);
+// simulates a FIFO cache of cacheSize entries over a triangle list
+CacheStats cacheStats(const std::vector<GLuint> & indices, size_t vertexCount, int cacheSize = VERTEX_CACHE_SIZE);
+// uploads to the bound GL_ELEMENT_ARRAY_BUFFER as 16-bit indices when they fit; returns the index type
+GLenum uploadIndices(const std::vector<GLuint> & indices, size_t vertexCount);
+
+#endif
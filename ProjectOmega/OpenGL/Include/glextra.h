@@ -0,0 +1,77 @@
+#ifndef GLEXTRA_H
+#define GLEXTRA_H
+
+#include <glad/glad.h>
+
+/*
+Entry points newer than the GL 3.3 core profile glad was generated for
+They are loaded with the same proc address function as glad, right after gladLoadGLLoader,
+and the flags in glExtras say which of them the driver actually has
+*/
+
+#ifndef GL_VERSION_4_0
+#define GL_PATCHES 0x000E
+#define GL_PATCH_VERTICES 0x8E72
+#define GL_MAX_TESS_GEN_LEVEL 0x8E7E
+#define GL_TESS_EVALUATION_SHADER 0x8E87
+#define GL_TESS_CONTROL_SHADER 0x8E88
+typedef void (APIENTRYP PFNGLPATCHPARAMETERIPROC)(GLenum pname, GLint value);
+GLAPI PFNGLPATCHPARAMETERIPROC glad_glPatchParameteri;
+#define glPatchParameteri glad_glPatchParameteri
+#endif
+
+#ifndef GL_VERSION_4_1
+#define GL_PROGRAM_BINARY_RETRIEVABLE_HINT 0x8257
+#define GL_PROGRAM_BINARY_LENGTH 0x8741
+#define GL_NUM_PROGRAM_BINARY_FORMATS 0x87FE
+typedef void (APIENTRYP PFNGLGETPROGRAMBINARYPROC)(GLuint program, GLsizei bufSize, GLsizei *length, GLenum *binaryFormat, void *binary);
+typedef void (APIENTRYP PFNGLPROGRAMBINARYPROC)(GLuint program, GLenum binaryFormat, const void *binary, GLsizei length);
+typedef void (APIENTRYP PFNGLPROGRAMPARAMETERIPROC)(GLuint program, GLenum pname, GLint value);
+GLAPI PFNGLGETPROGRAMBINARYPROC glad_glGetProgramBinary;
+GLAPI PFNGLPROGRAMBINARYPROC glad_glProgramBinary;
+GLAPI PFNGLPROGRAMPARAMETERIPROC glad_glProgramParameteri;
+#define glGetProgramBinary glad_glGetProgramBinary
+#define glProgramBinary glad_glProgramBinary
+#define glProgramParameteri glad_glProgramParameteri
+#endif
+
+#ifndef GL_VERSION_4_3
+#define GL_COMPUTE_SHADER 0x91B9
+#define GL_TEXTURE_FETCH_BARRIER_BIT 0x00000008
+#define GL_SHADER_IMAGE_ACCESS_BARRIER_BIT 0x00000020
+#define GL_FRAMEBUFFER_BARRIER_BIT 0x00000400
+#define GL_MAX_COMPUTE_SHARED_MEMORY_SIZE 0x8262
+typedef void (APIENTRYP PFNGLDISPATCHCOMPUTEPROC)(GLuint num_groups_x, GLuint num_groups_y, GLuint num_groups_z);
+typedef void (APIENTRYP PFNGLBINDIMAGETEXTUREPROC)(GLuint unit, GLuint texture, GLint level, GLboolean layered, GLint layer, GLenum access, GLenum format);
+typedef void (APIENTRYP PFNGLMEMORYBARRIERPROC)(GLbitfield barriers);
+GLAPI PFNGLDISPATCHCOMPUTEPROC glad_glDispatchCompute;
+GLAPI PFNGLBINDIMAGETEXTUREPROC glad_glBindImageTexture;
+GLAPI PFNGLMEMORYBARRIERPROC glad_glMemoryBarrier;
+#define glDispatchCompute glad_glDispatchCompute
+#define glBindImageTexture glad_glBindImageTexture
+#define glMemoryBarrier glad_glMemoryBarrier
+#endif
+
+#ifndef GL_VERSION_4_4
+#define GL_MAP_PERSISTENT_BIT 0x0040
+#define GL_MAP_COHERENT_BIT 0x0080
+#define GL_DYNAMIC_STORAGE_BIT 0x0100
+#define GL_CLIENT_STORAGE_BIT 0x0200
+typedef void (APIENTRYP PFNGLBUFFERSTORAGEPROC)(GLenum target, GLsizeiptr size, const void *data, GLbitfield flags);
+GLAPI PFNGLBUFFERSTORAGEPROC glad_glBufferStorage;
+#define glBufferStorage glad_glBufferStorage
+#endif
+
+struct GLExtras {
+	bool programBinary = false;		// GL 4.1 or ARB_get_program_binary, with at least one binary format
+	bool bufferStorage = false;		// GL 4.4 or ARB_buffer_storage (persistently mapped buffers)
+	bool compute = false;			// GL 4.3 compute shaders and image load/store, with 32 KB of shared memory
+	bool tessellation = false;		// GL 4.0 tessellation shaders, with levels up to 64
+};
+
+extern GLExtras glExtras;
+
+bool hasGLExtension(const char * name);
+void loadGLExtras(GLADloadproc load);
+
+#endif
@@ -0,0 +1,47 @@
+#ifndef GLSTATE_H
+#define GLSTATE_H
+
+#include <glad/glad.h>
+
+#define GL_STATE_UNITS 16		// texture units tracked; binds to higher units always reach GL
+#define GL_STATE_TARGETS 2		// texture targets tracked per unit: 2D, cube map
+
+struct GLState {
+	/*
+	Shadow of the state the frame loop changes: program, vertex array, framebuffer, textures per unit,
+	depth test / cull face / scissor test, front face, depth function and viewport
+	The functions below only call GL when the value differs from the shadow, so every pass can set the
+	state it needs without knowing what the pass before it left behind. Code that changes any of this
+	directly (target allocation, texture uploads, program setup) must call invalidateGLState afterwards;
+	deleting a texture or framebuffer counts too, since GL unbinds it and may hand its name out again
+	*/
+	GLuint program, vao, fbo;
+	GLuint unit;										// active texture unit
+	GLuint textures[GL_STATE_UNITS][GL_STATE_TARGETS];
+	GLint depthTest, cullFace, scissorTest;				// -1 while unknown
+	GLenum frontFace, depthFunc;
+	GLint viewport[4];
+
+	unsigned calls = 0, skipped = 0;					// state changes sent to GL / dropped as redundant
+};
+
+extern GLState glState;
+
+// forgets the shadowed values, so the next call of each kind reaches GL
+void invalidateGLState();
+
+void useProgram(GLuint program);
+void bindVertexArray(GLuint vao);
+// binds fbo for drawing and reading
+void bindFramebuffer(GLuint fbo);
+// binds texture to target on the given unit; the active unit only changes when the bind reaches GL
+void bindTexture(GLuint unit, GLenum target, GLuint texture);
+// makes unit active, for calls that act on the active unit's binding (glGenerateMipmap, glGetTexImage)
+void activeTexture(GLuint unit);
+// GL_DEPTH_TEST, GL_CULL_FACE or GL_SCISSOR_TEST (anything else is passed through)
+void setCapability(GLenum cap, bool enabled);
+void setFrontFace(GLenum mode);
+void setDepthFunc(GLenum func);
+void setViewport(GLint x, GLint y, GLsizei width, GLsizei height);
+
+#endif
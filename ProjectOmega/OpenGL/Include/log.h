@@ -0,0 +1,56 @@
+#ifndef LOG_H
+#define LOG_H
+
+#include <atomic>
+#include <thread>
+
+#define LOG_RING 128			// messages in flight; while the drain thread is this far behind, new ones are dropped
+#define LOG_LINE 1280			// characters per message (a shader info log fits), longer ones are cut
+#define LOG_POLL_MS 5			// how long the drain thread sleeps when the ring is empty
+
+enum LogLevel { LOG_DEBUG, LOG_INFO, LOG_WARN, LOG_ERROR };
+
+struct LogEntry {
+	LogLevel level;
+	char text[LOG_LINE];
+};
+
+struct Logger {
+	/*
+	Single-producer ring of formatted messages, written out by a background thread
+	logMessage formats into the next free entry and publishes it by advancing head; the drain thread
+	writes entries up to head (warnings and errors to stderr, the rest to stdout) and advances tail. The
+	producer never waits: with the ring full the message is dropped and counted, and the drain thread
+	reports the count. Only one thread may log, the render thread.
+	Until startLogger runs the messages are written synchronously, so tools that never start it (the
+	benchmark) keep their output in order with their own printf
+	*/
+	LogEntry ring[LOG_RING];
+	std::atomic<unsigned> head{ 0 }, tail{ 0 };	// free-running: entries tail..head-1 are waiting
+	std::atomic<unsigned> dropped{ 0 };
+	std::atomic<bool> running{ false };
+	std::thread drain;
+	LogLevel level = LOG_INFO;					// messages below this are discarded before formatting
+};
+
+struct LogLimit {
+	/*
+	Rate limit of one call site: at most one message per interval seconds, the next one that gets
+	through says how many were suppressed in between
+	*/
+	double interval = 1.0;
+	double next = 0.0;		// seconds on the steady clock
+	unsigned suppressed = 0;
+};
+
+extern Logger logger;
+
+// starts the drain thread; it is stopped (after writing everything queued) at exit
+void startLogger(LogLevel level = LOG_INFO);
+void stopLogger();
+
+// printf-style
+void logMessage(LogLevel level, const char * format, ...);
+void logLimited(LogLimit & limit, LogLevel level, const char * format, ...);
+
+#endif
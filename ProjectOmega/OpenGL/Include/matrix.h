@@ -0,0 +1,71 @@
+#ifndef MATRIX_H
+#define MATRIX_H
+
+#include <glad/glad.h>
+#include <assert.h>
+#include <cmath>
+#include <iostream>
+
+const GLfloat PI = (GLfloat)acos(-1);
+
+struct Matrix4 {
+	GLfloat data[16];
+	/*
+	should be column-major, meaning the matrix looks like
+	0  4  8 12
+	1  5  9 13
+	2  6 10 14
+	3  7 11 15
+	*/
+	Matrix4() {
+		// instantiate as an identity matrix
+		for (int i = 0; i < 4; i++) {
+			for (int j = 0; j < 4; j++) {
+				data[i + j * 4] = i == j ? 1.f : 0.f;
+			}
+		}
+	}
+
+	void set(GLuint row, GLuint col, GLfloat val) {
+		// sets the value of the element in the given index
+		assert(row > -1 || row < 4 || col > -1 || col < 4);
+		data[col * 4 + row] = val;
+	}
+
+	GLfloat get(GLuint row, GLuint col) {
+		// retrieves a value in the given index
+		assert(row > -1 || row < 4 || col > -1 || col < 4);
+		return data[col * 4 + row];
+	}
+
+	void print() {
+		// for debugging
+		std::cout << data[0] << " " << data[4] << " " << data[8] << " " << data[12] << "\n";
+		std::cout << data[1] << " " << data[5] << " " << data[9] << " " << data[13] << "\n";
+		std::cout << data[2] << " " << data[6] << " " << data[10] << " " << data[14] << "\n";
+		std::cout << data[3] << " " << data[7] << " " << data[11] << " " << data[15] << "\n\n";
+	}
+};
+
+struct Vector4 {
+	GLfloat x, y, z, w; // column vector
+	Vector4(GLfloat x, GLfloat y, GLfloat z, GLfloat w) : x(x), y(y), z(z), w(w) {
+
+	}
+
+	Vector4(GLfloat n) {
+		x, y, z, w = n;
+	}
+
+	Vector4() {
+		x, y, z, w = 1.f;
+	}
+};
+
+Vector4 multiply(Matrix4 a, Vector4 b);
+Matrix4 multiply(Matrix4 a, Matrix4 b);
+Matrix4 rotate(Matrix4 mat, GLfloat a, GLfloat x, GLfloat y, GLfloat z);
+Matrix4 translate(Matrix4 mat, GLfloat x, GLfloat y, GLfloat z);
+Matrix4 scale(Matrix4 mat, GLfloat x, GLfloat y, GLfloat z);
+
+#endif
@@ -0,0 +1,76 @@
+#ifndef OCEAN_H
+#define OCEAN_H
+
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+#include <vector>
+#include <workers.h>
+
+#define OCEAN_SIZE 256					// FFT size, a power of two
+#define OCEAN_SIZE_MAX 512
+#define OCEAN_PATCH 64.f				// meters of ocean one tile of the spectrum covers
+#define OCEAN_WIND 6.f					// wind speed, m/s
+#define OCEAN_WIND_DIR 0.5f				// radians from +x
+#define OCEAN_AMPLITUDE 5e-5f			// Phillips constant
+#define OCEAN_CHOP 1.f					// horizontal displacement relative to the height
+#define OCEAN_GRAVITY 9.81f
+#define OCEAN_SEED 1234u				// the random phases, so every run shows the same sea
+#define OCEAN_UPLOADS 3					// pixel unpack buffers in flight
+#define OCEAN_UNIT 1					// texture unit of the displacement; the normals use the next one
+
+struct Ocean {
+	/*
+	Tessendorf ocean: a Phillips spectrum of wind waves, animated by the deep water dispersion
+	w^2 = g|k| and brought back to space by an inverse FFT every frame
+	Five real fields come out of three complex transforms: height + i x slope, z slope + i x displacement
+	and z displacement. The displacement texture holds x, height and z displacement and the normal texture
+	the x and z slopes, both in scene units for a tile of extent.
+	The CPU path evaluates the spectrum and runs radix-2 Stockham transforms on a worker pool: columns in
+	strips of independent columns, four at a time with SSE where the compiler targets it, then a transpose
+	and the same again for the rows. The results are written straight into the mapped unpack buffer of a
+	ring of OCEAN_UPLOADS, each reused only once its fence has passed.
+	The GPU path (gpu set) runs the same transforms as fragment passes over float targets, one per stage
+	and direction, so it needs nothing beyond GL 3.3
+	*/
+	GLsizei size = 0;
+	GLfloat extent = 1.f;			// scene units of one tile
+	bool gpu = false;
+
+	std::vector<GLfloat> h0;		// per wave vector: h0(k) and conj(h0(-k)), 4 floats
+	std::vector<GLfloat> twiddle;	// cos, sin of 2 pi i / size for i < size / 2
+	std::vector<GLfloat> planes[2];	// 3 fields of real and imaginary planes, ping-ponged by the FFT stages
+
+	GLuint displacement = 0, normals = 0;
+	GLuint pbo[OCEAN_UPLOADS] = {};
+	GLsync fences[OCEAN_UPLOADS] = {};
+	int next = 0;
+
+	GLuint spectrumprogram = 0, fftprogram = 0, resolveprogram = 0;
+	GLint s_h0 = -1, s_time = -1, s_patch = -1;
+	GLint f_a = -1, f_b = -1, f_stage = -1, f_vertical = -1;
+	GLint r_a = -1, r_b = -1, r_scale = -1, r_chop = -1;
+	GLuint h0Tex = 0, fbo[2] = { 0, 0 }, tex[2][2] = {};	// spectrum ping-pong: fields 0, 1 and field 2
+	GLuint outFbo = 0;
+
+	// CPU runs since the last reset and the milliseconds they spent on the spectrum, the transforms and
+	// packing into the upload buffer
+	unsigned runs = 0;
+	double spectrumMs = 0.0, fftMs = 0.0, packMs = 0.0;
+	unsigned stalls = 0;			// uploads that had to wait for the GPU to release their buffer
+};
+
+// (re)allocates a size x size ocean whose tile covers extent scene units
+void setupOcean(Ocean & o, GLsizei size, GLfloat extent, bool gpu);
+void releaseOcean(Ocean & o);
+// the CPU half of setupOcean, the spectrum and the transform buffers; needs no GL context
+void setupOceanSpectrum(Ocean & o, GLsizei size, GLfloat extent);
+void resetOceanStats(Ocean & o);
+// whether the CPU transforms were built with SSE2 butterflies
+bool oceanSse();
+
+// CPU path without GL: the displacement (4 floats) and then the normal (2 floats) texels of the ocean at time into out
+void simulateOcean(Ocean & o, WorkerPool & pool, GLfloat time, GLfloat * out);
+// updates the textures for time (seconds) on either path; leaves them bound to OCEAN_UNIT and the next unit
+void runOcean(Ocean & o, WorkerPool & pool, GLfloat time, GLuint screenVAO);
+
+#endif
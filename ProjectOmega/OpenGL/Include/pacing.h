@@ -0,0 +1,45 @@
+#ifndef PACING_H
+#define PACING_H
+
+#include <glad/glad.h>
+#include <chrono>
+
+#define FRAME_CONTEXTS 3			// frames the CPU may queue ahead of the GPU by default
+#define FRAME_CONTEXTS_MAX 4		// frame contexts allocated, so the most frames in flight
+
+struct FrameContext {
+	GLsync fence = 0;				// after the frame's last command, 0 while the context is free
+	GLuint queries[2] = { 0, 0 };	// GL_TIMESTAMP when the GPU starts and finishes the frame
+};
+
+struct FramePacer {
+	/*
+	Frames in flight
+	Each frame runs in one of frames contexts, taken in turn. beginFrame waits until the GPU is done with
+	the frame that last used the context (its fence), so the CPU never gets more than frames frames ahead,
+	and the context's slice of the per-frame buffers (UniformRing) is free to overwrite. Fewer frames cut
+	the latency between input and display, more keep the GPU busy while the CPU stalls.
+	The wait is the CPU wait time; the gap between a frame's start timestamp on the GPU and the previous
+	frame's end is the GPU idle time. Both timestamps are read once the fence has passed, so never stall.
+	*/
+	int frames = FRAME_CONTEXTS;	// frames in flight, 1..FRAME_CONTEXTS_MAX; change with setFramesInFlight
+	FrameContext contexts[FRAME_CONTEXTS_MAX];
+	int current = 0;				// context of the frame being recorded
+	GLuint64 lastEnd = 0;			// GPU end timestamp of the last retired frame, 0 before the first
+
+	double latestWaitMs = 0.0, latestIdleMs = 0.0;
+	double waitMs = 0.0, idleMs = 0.0;	// sums since the last reset
+	unsigned waits = 0, idles = 0;		// frames begun, and frame gaps measured, since the last reset
+};
+
+void setupFramePacer(FramePacer & p);
+void releaseFramePacer(FramePacer & p);
+// waits for the next context and returns it (the slice of the per-frame buffers the frame may write)
+int beginFrame(FramePacer & p);
+// fences the frame's commands and flushes them to the GPU
+void endFrame(FramePacer & p);
+// waits for every frame in flight first, so lowering the count never leaves a context behind
+void setFramesInFlight(FramePacer & p, int frames);
+void resetFramePacerStats(FramePacer & p);
+
+#endif
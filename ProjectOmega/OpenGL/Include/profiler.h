@@ -0,0 +1,91 @@
+#ifndef PROFILER_H
+#define PROFILER_H
+
+#include <glad/glad.h>
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+// frames a query may stay in flight before its slot is reused (results are read this many frames late)
+#define PROFILER_RING 4
+
+struct PassStats {
+	double min, avg, p99;	// milliseconds
+};
+
+struct PassTimer {
+	std::string name;
+	GLuint queries[PROFILER_RING][2];	// GL_TIMESTAMP pair per ring slot, so passes may nest
+	bool pending[PROFILER_RING];
+	std::chrono::steady_clock::time_point cpuStart;
+	std::vector<double> gpuMs, cpuMs;	// samples since the last report
+};
+
+struct Profiler {
+	/*
+	Pass-scoped GPU/CPU timer
+	Every pass brackets its commands with a pair of GL_TIMESTAMP queries and a CPU wall-clock scope,
+	and the whole frame is wrapped in a GL_TIME_ELAPSED query. Queries live in a ring of PROFILER_RING
+	frames and are only read back once available, so the profiler never waits on the GPU.
+	Every reportEvery frames min/avg/p99 per pass are appended to path (CSV, or JSON lines for *.json).
+	The frame thread only formats the rows and queues them; a writer thread started by setupProfiler
+	appends them to the file, so a report never blocks the frame on I/O
+	*/
+	std::vector<PassTimer> passes;
+	GLuint frameQueries[PROFILER_RING];
+	bool framePending[PROFILER_RING];
+	std::vector<double> frameMs;
+	double latestFrameMs = 0.0;		// result that came back at the last profilerFrameBegin, 0 if none did
+	std::chrono::steady_clock::time_point frameStart;
+	std::vector<double> frameCpuMs;
+
+	int slot = 0;					// ring slot of the current frame
+	unsigned long long frame = 0;
+	int reportEvery = 300;
+	std::string path;
+	bool json = false;
+	GLuint dropped = 0;				// results that were still not available when their slot came around
+
+	std::thread writer;
+	std::mutex mutex;
+	std::condition_variable wake;
+	std::string queued;				// formatted rows the writer has not taken yet
+	bool quit = false;
+
+	~Profiler();					// writes what is queued and joins the writer
+};
+
+void setupProfiler(Profiler & p, const std::string & path, int reportEvery);
+// writes the queued reports and stops the writer thread
+void releaseProfiler(Profiler & p);
+// registers a named pass and returns its id for profilerBegin / profilerEnd
+int profilerPass(Profiler & p, const std::string & name);
+
+void profilerBegin(Profiler & p, int pass);
+void profilerEnd(Profiler & p, int pass);
+
+struct ProfileScope {
+	/*
+	Times the enclosing block as the given pass
+	*/
+	Profiler & p;
+	int pass;
+	ProfileScope(Profiler & p, int pass) : p(p), pass(pass) { profilerBegin(p, pass); }
+	~ProfileScope() { profilerEnd(p, pass); }
+};
+
+void profilerFrameBegin(Profiler & p);
+void profilerFrameEnd(Profiler & p);
+
+void profilerFinish(Profiler & p);
+void profilerReset(Profiler & p);
+
+PassStats passStats(std::vector<double> samples);
+double elapsedMs(std::chrono::steady_clock::time_point since);
+// queues the stats since the last report for the writer thread and clears them
+void writeProfilerReport(Profiler & p);
+
+#endif
@@ -0,0 +1,30 @@
+#ifndef RESOLUTION_H
+#define RESOLUTION_H
+
+#include <glad/glad.h>
+
+#define RESOLUTION_STEP 0.05f		// render scale granularity, every change reallocates the offscreen targets
+#define RESOLUTION_WINDOW 8			// frame times averaged before the scale may change again
+#define RESOLUTION_HEADROOM 0.9f	// fraction of the budget a new scale aims for
+#define RESOLUTION_LOW 0.75f		// the scale only grows while frames take less than this fraction of the budget
+
+struct DynamicResolution {
+	/*
+	Frame-time driven render scale (fraction of the output size per axis)
+	GPU frame times are smoothed over RESOLUTION_WINDOW frames; above budgetMs the scale shrinks, below
+	RESOLUTION_LOW * budgetMs it grows, each time to the size whose pixel count should land at RESOLUTION_HEADROOM
+	of the budget. After a change the next RESOLUTION_WINDOW results are skipped since the profiler reports late
+	*/
+	GLfloat budgetMs = 0.f;			// 0 keeps the scale fixed
+	GLfloat minScale = 0.5f, maxScale = 1.f;
+	GLfloat scale = 1.f;
+
+	double smoothedMs = 0.0;
+	int samples = 0;				// results since the last change, negative while frames of the old size are in flight
+	int changes = 0;
+};
+
+// feeds the GPU time of a finished frame (0 if none came back) and returns the scale for the next frame
+GLfloat updateDynamicResolution(DynamicResolution & d, double gpuMs);
+
+#endif
@@ -0,0 +1,145 @@
+#ifndef SCENE_H
+#define SCENE_H
+
+#include <glad/glad.h>
+#include <string>
+#include <vector>
+#include <glutil.h>
+#include <caustics.h>
+#include <ocean.h>
+#include <blur.h>
+#include <dof.h>
+#include <framegraph.h>
+#include <pacing.h>
+#include <profiler.h>
+#include <uniforms.h>
+#include <waterlod.h>
+#include <watersim.h>
+#include <workers.h>
+
+#define BLUR_PASSES 10							// passes of the legacy full-resolution blur (frame.fsh)
+#define LEGACY_BLUR_OFFSET (1.f / 300.f)		// tap distance of the legacy blur as a fraction of the target width
+#define FOV_Y 45.f								// vertical field of view, degrees
+#define REFRACT_SCALE 0.5f						// refraction target relative to the render size (only sampled under the water)
+#define WATER_STYLES 5							// STYLE variants of reflect.vsh (keys Q/W/E/T/Y)
+#define WATER_SIM_STYLE 3						// the style that shows the simulated heightfield
+#define WATER_OCEAN_STYLE 4						// the style that shows the FFT ocean
+#define COMBINE_OUTPUTS 4						// SELECTION variants of combine.fsh (keys 1-4)
+#define WATER_RESOLUTION 100					// quads per side of the water plane
+#define WATER_RESOLUTION_MAX 2048				// finest bufferless water grid
+#define WATER_LOD_FIXED 0						// Scene::waterLod: the uniform grid of waterResolution
+#define WATER_LOD_TESS 1						// patches tessellated by their edges' length on screen (GL 4.0)
+#define WATER_LOD_QUADTREE 2					// nodes of a quadtree selected on the CPU (WaterLod)
+#define WATER_LOD_MODES 3
+#define WATER_LOD_PIXELS 4.f					// largest spacing of the adaptive water's vertices on screen
+#define WATER_TESS_PATCHES 16					// patches per side of the tessellated water
+#define WATER_RAIN 0.4f							// seconds between two scripted drops on the simulated water
+#define WATER_DROP_RADIUS 0.015f				// scene units
+#define WATER_DROP_HEIGHT -0.006f
+#define WATER_FLOAT_RADIUS 0.03f				// the object circling the simulated water
+#define WATER_FLOAT_DEPTH 0.006f
+
+struct FrameParams {
+	/*
+	Everything a frame depends on that comes from outside the renderer (input, window, clock)
+	*/
+	glm::vec3 cameraPos, cameraFront, cameraUp;
+	GLfloat time;				// seconds since startup, drives the water and the focus
+	int selection, style;		// combine output 1-4 and water style 0-4 (keys 1-4, Q/W/E/T/Y), each a program variant
+	bool blurDof;				// depth of field mixes in the blur below instead of gathering
+	bool autofocus;				// focus on the depth under the autofocus region instead of the scripted sweep
+	bool legacyBlur, measureBlur;
+};
+
+// pixel rectangle of a box's projection in a width x height target; false if the box is entirely off-screen
+// (a box that reaches behind the camera is treated as covering the whole target)
+bool projectedRect(const glm::mat4 & mvp, glm::vec3 lo, glm::vec3 hi, GLsizei width, GLsizei height, GLint rect[4]);
+
+// points the camera along yaw/pitch (degrees) from one unit back of the origin
+void orbitCamera(GLfloat yaw, GLfloat pitch, glm::vec3 & front, glm::vec3 & pos);
+
+struct Scene {
+	/*
+	All GL objects of the pool scene and the passes that draw it
+	The frame is a FrameGraph built by buildFrameGraph: the water simulation steps or the ocean transforms
+	run if the style shows them, the caustics of that water on the pool floor, then refraction (scaled down and scissored to the water), water, pool and
+	skybox, the blur if the depth of field blends one in, autofocus, the depth of field, and finally the
+	combine pass into whichever framebuffer is given. Passes whose results the combine output does not
+	need are culled, and the transient targets are pooled by the graph
+	Everything up to the combine pass renders at renderWidth x renderHeight, the combine pass upscales
+	to the output size with bilinear fetches
+	*/
+	GLsizei width, height;					// output size
+	GLsizei renderWidth = 0, renderHeight = 0;	// size of the offscreen targets, renderScale times the output size
+	GLfloat renderScale = 1.f;
+	GLfloat blurScale;						// pyramid sigma per pixel of target width, so the blur keeps its look at any size
+	GLfloat refractScale = REFRACT_SCALE;
+	GLsizei refractWidth = 0, refractHeight = 0;
+	bool refractCull = true;				// scissor the refraction to the water and skip it while the water is off-screen
+
+	unsigned int skyboxVAO, skyboxVBO;
+	GLuint sphereVAO, sphereVBO, cubeVAO, cubeVBO, cubeTexVAO, cubeTexVBO, planeVAO, planeVBO, screenVAO, screenVBO;
+	GLuint newPlaneVAO = 0, newPlaneVBO = 0;	// made on the first frame that draws the water mesh
+	GLuint waterGridVAO;					// no attributes, the bufferless grid needs one bound all the same
+	GLuint sphereEBO, cubeEBO, cubeTexEBO, planeEBO, newPlaneEBO;
+	IndexedMesh<Vertex> sphere, cube, plane;
+	IndexedMesh<NewVertex> texcube, newPlane;
+
+	FrameGraph graph;
+	FrameParams graphParams = {};			// the switches the graph was built for, it is rebuilt when they change
+	GLuint graphTarget = 0;
+	int r_heightfield, r_ocean, r_caustics, r_refract, r_refractDepth, r_color, r_depth, r_blur[2], r_pyramid, r_focus, r_dof, r_output;
+	glm::vec3 waterOrigin, waterU, waterV;	// the water plane: corner and its two sides
+	glm::vec3 waterMin, waterMax;			// bounds of the water plane, the only reader of the refraction
+	bool waterGrid = true;					// water from gl_VertexID / gl_InstanceID (watergrid.glsl), no vertex buffer; off: the newPlane mesh
+	GLuint waterResolution = WATER_RESOLUTION;	// quads per side of the grid, free to change between frames (the mesh keeps WATER_RESOLUTION)
+	int waterLod = WATER_LOD_FIXED;			// how the bufferless water is tessellated; initScene picks the adaptive one the context has
+	GLfloat waterLodPixels = WATER_LOD_PIXELS;
+	WaterLod lod;							// nodes of WATER_LOD_QUADTREE
+	GLuint waterQuery = 0;					// if set, a GL_PRIMITIVES_GENERATED query around the water draw
+	WaterSim sim;							// heightfield of WATER_SIM_STYLE, only stepped while that style is drawn
+	int waterFloat;							// sim object circling the pool
+	int rainDrops = 0;						// scripted drops so far
+	Ocean ocean;							// displacement and normals of WATER_OCEAN_STYLE, only updated while that style is drawn
+	WorkerPool workers;						// threads of the ocean's CPU transforms
+	Caustics caustics;						// the water's light on the pool floor, redrawn every frame
+	glm::vec3 sunlight;						// direction of the light the caustics focus
+	BlurPyramid pyramid;
+	DepthOfField dof;
+	Autofocus autofocus;
+
+	// what the passes of the current frame read
+	FrameParams params;
+	PerFrame perFrame;
+	GLintptr refractPoolOffset, waterOffset, poolOffset, waterGridOffset, causticsGridOffset;
+
+	GLuint sbox, dudvmap, pooltex;
+
+	GLuint skyboxprogram, transprogram, frameprogram, poolprogram;
+	GLuint sphereprograms[WATER_STYLES] = {}, combineprograms[COMBINE_OUTPUTS] = {};	// built on first use
+	GLuint gridprograms[WATER_LOD_MODES][WATER_STYLES] = {};
+	GLuint causticsprograms[WATER_STYLES] = {};
+	GLint s_cube;
+	GLuint u_cube, u_dudv, u_pooltex, u_poolnorm;
+	GLuint t_cube, t_pooltex;
+	GLint f_frametex, f_offset;
+	GLuint c_pristineTex, c_dofTex;
+	GLuint p_pool_tex, p_caustics;
+	UniformRing uniforms;			// PerFrame and PerDraw blocks of every frame
+	FramePacer pacer;				// frames in flight; each one's blocks live in its slice of uniforms
+
+	glm::vec3 lightpos, lightcol;
+
+	Profiler profiler;
+	int pass_watersim, pass_ocean, pass_caustics, pass_refract, pass_water, pass_pool, pass_skybox, pass_blur, pass_legacyBlur, pass_autofocus, pass_dof, pass_combine;
+};
+
+// returns false if a framebuffer could not be completed
+bool initScene(Scene & s, GLsizei width, GLsizei height, GLfloat blurRadius, const std::string & profileOutput, int profileEvery);
+// resizes the offscreen targets for a new output size or render scale, returns false if a framebuffer is incomplete
+bool resizeScene(Scene & s, GLsizei width, GLsizei height, GLfloat renderScale);
+// declares the frame's passes for the switches in f and compiles the graph, returns false if a framebuffer is incomplete
+bool buildFrameGraph(Scene & s, const FrameParams & f, GLuint targetFbo);
+void renderScene(Scene & s, const FrameParams & f, GLuint targetFbo);
+
+#endif
@@ -0,0 +1,29 @@
+#ifndef SHADERS_H
+#define SHADERS_H
+
+#include <glad/glad.h>
+#include <string>
+#include <vector>
+
+#define SHADER_CACHE_DIR "shader_cache"	// linked program binaries, keyed by driver and source (delete to force a cold start)
+#define SHADER_INCLUDE_DEPTH 8			// nested #include levels before the preprocessor gives up
+
+struct ShaderCacheStats {
+	int hits = 0, misses = 0;	// programs loaded from the cache / compiled from source
+	double ms = 0.0;			// time spent building programs
+	int reused = 0;				// requests answered with a program this process had already built
+};
+
+extern ShaderCacheStats shaderCacheStats;
+
+// compile and link a program from shader files, printing the info log of any stage that fails
+// each stage gets #include "file" resolved and the defines ("NAME" or "NAME value") inserted after #version;
+// a program is built once per combination of files and defines, asking again returns the same one
+GLuint loadProgram(const GLchar* vsh, const GLchar* fsh, const std::vector<std::string> & defines = {});
+GLuint loadProgram(const GLchar* vsh, const GLchar* gsh, const GLchar* fsh, const std::vector<std::string> & defines = {});
+// vertex, tessellation control, tessellation evaluation and fragment shaders; only call when glExtras.tessellation is set
+GLuint loadTessProgram(const GLchar* vsh, const GLchar* tcs, const GLchar* tes, const GLchar* fsh, const std::vector<std::string> & defines = {});
+GLuint loadComputeProgram(const GLchar* csh, const std::vector<std::string> & defines = {});
+void checkForErrors(unsigned int shader, std::string type);
+
+#endif
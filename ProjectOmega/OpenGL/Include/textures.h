@@ -0,0 +1,23 @@
+#ifndef TEXTURES_H
+#define TEXTURES_H
+
+#include <glad/glad.h>
+#include <string>
+#include <vector>
+#include "stb_image.h"
+
+struct TextureLoad {
+	GLuint * tex;
+	GLuint texUnit;
+	GLenum target;						// GL_TEXTURE_2D or GL_TEXTURE_CUBE_MAP
+	std::vector<std::string> files;	// one file for a 2D texture, six (+x, -x, +y, -y, +z, -z) for a cubemap
+};
+
+// decodes every file on a pool of worker threads and copies it into one mapped pixel buffer, then uploads each image once;
+// a texture missing an image gets a 1x1 placeholder
+void loadTextures(const std::vector<TextureLoad> & loads, unsigned threads = 0);
+
+void loadTexture(GLuint * tex, GLuint texUnit, const GLchar * fileName);
+GLuint loadCubemap(std::vector<std::string> f);
+
+#endif
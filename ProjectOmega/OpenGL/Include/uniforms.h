@@ -0,0 +1,67 @@
+#ifndef UNIFORMS_H
+#define UNIFORMS_H
+
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+#include <pacing.h>
+
+#define PER_FRAME_BINDING 0		// uniform buffer binding points of the PerFrame / PerDraw blocks
+#define PER_DRAW_BINDING 1
+#define WATER_GRID_BINDING 2		// WaterGrid block of shaders/watergrid.glsl
+#define UNIFORM_RING_FRAMES FRAME_CONTEXTS_MAX	// slices, one per frame context
+#define UNIFORM_RING_BLOCKS 16		// blocks a frame may write
+
+// std140 mirrors of the blocks declared in shaders/uniforms.glsl, keep the member order in sync
+struct PerFrame {
+	glm::mat4 view;
+	glm::mat4 projection;
+	glm::vec3 eyePos;
+	GLfloat time;			// seconds
+	glm::vec3 lightPos;
+	GLfloat focus;			// depth of field: focus distance in scene units
+	glm::vec3 lightColor;
+	GLfloat pad0;
+};
+
+struct PerDraw {
+	glm::mat4 model;
+	glm::vec4 clipPlane;
+};
+
+struct WaterGrid {
+	glm::vec3 origin;		// corner at column 0, row 0
+	GLint resolution;		// quads per side (patches per side tessellated, quads per quadtree node side)
+	glm::vec3 u;			// the whole grid along the columns
+	GLfloat lod;			// pixels per radian over the target spacing in pixels
+	glm::vec3 v;			// the whole grid along the rows
+	GLfloat morph;			// part of a quadtree node's range spent morphing to its parent
+};
+
+struct UniformRing {
+	/*
+	Uniform buffer split into UNIFORM_RING_FRAMES slices, one per frame context of the FramePacer
+	With buffer storage the whole buffer stays mapped (persistent, coherent); otherwise the slice is
+	mapped unsynchronized for the writes. Either way the pacer has waited for the context's fence, so
+	the GPU is done reading the blocks the CPU overwrites.
+	*/
+	GLuint buffer = 0;
+	GLint align = 256;				// GL_UNIFORM_BUFFER_OFFSET_ALIGNMENT
+	GLsizeiptr sliceSize = 0;
+	bool persistent = false;
+	unsigned char * mapped = NULL;	// whole buffer when persistent, else the current slice while writing
+	int slice = 0;
+	GLsizeiptr used = 0;			// bytes written to the current slice
+};
+
+void setupUniformRing(UniformRing & r);
+// makes the slice of the frame context beginFrame returned writable
+void uniformRingBegin(UniformRing & r, int slice);
+// copies a block into the current slice and returns its offset in the buffer
+GLintptr uniformRingWrite(UniformRing & r, const void * data, GLsizeiptr size);
+// makes the writes visible (unmaps the slice if the buffer is not persistent); call before drawing
+void uniformRingCommit(UniformRing & r);
+
+// points the PerFrame / PerDraw / WaterGrid blocks of program (where it has them) at their binding points
+void bindUniformBlocks(GLuint program);
+
+#endif
@@ -0,0 +1,52 @@
+#ifndef WATERLOD_H
+#define WATERLOD_H
+
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+#include <vector>
+#include <pacing.h>
+
+#define WATER_LOD_NODE 32				// quads per side of every quadtree node
+#define WATER_LOD_DEPTH 8				// levels below the whole water
+#define WATER_LOD_MORPH 0.2f			// last part of a node's range, where its vertices morph to its parent's grid
+#define WATER_LOD_MIN_RANGE (1.4143f / (1.f - 2.f * WATER_LOD_MORPH))	// node sizes a node's range covers at least, see WaterLod
+#define WATER_LOD_NODES_MAX 1024		// nodes a frame may draw, further splits are skipped
+
+struct WaterLod {
+	/*
+	Restricted quadtree over the water, selected on the CPU every frame for the camera
+	A node is split while it is nearer the eye than its range, the distance from where its vertex spacing
+	looks no larger than the target; ranges halve with each level. Each selected node is drawn as the same
+	WATER_LOD_NODE grid, one instance each (watergrid.glsl), and in the last WATER_LOD_MORPH of its range
+	its odd vertices slide onto its parent's grid. A coarser neighbour is always past that range, so the
+	vertices along a shared edge match (no cracks and no popping). A split node is nearer than its range R,
+	so the edge its children share with a coarser neighbour is nearer than R plus its diagonal; that is
+	short of the neighbour's morph from 2 (1 - WATER_LOD_MORPH) R, and of the 2 R a neighbour two levels
+	coarser would need, once R is WATER_LOD_MIN_RANGE node sizes (sqrt 2 / (1 - 2 WATER_LOD_MORPH), about 2.4).
+	Any more only adds finer nodes where the target needs none.
+	The nodes stream through a buffer of one slice per frame context, which the pacer has freed when it is
+	written, like the uniform ring.
+	*/
+	std::vector<glm::vec4> nodes;	// corner u, v and size as fractions of the water, and where the morph ends
+	int depth = 0;					// deepest level selected
+	unsigned skipped = 0;			// splits WATER_LOD_NODES_MAX left out, since setup
+
+	GLuint vao = 0, buffer = 0;
+	GLintptr offset = 0;			// of the nodes uploaded last
+};
+
+void setupWaterLod(WaterLod & l);
+void releaseWaterLod(WaterLod & l);
+
+// selects the nodes of the water origin + a u + b v (u, v perpendicular) for an eye; lod is pixels per radian
+// over the largest vertex spacing in pixels allowed
+void selectWaterLod(WaterLod & l, glm::vec3 eye, glm::vec3 origin, glm::vec3 u, glm::vec3 v, GLfloat lod);
+// copies the selection into the slice of a frame context
+void uploadWaterLod(WaterLod & l, int context);
+// draws the uploaded nodes with the bound program
+void drawWaterLod(const WaterLod & l);
+
+// quads per side a uniform grid needs to keep within the same bound everywhere, seen from eye
+GLuint waterLodResolution(glm::vec3 eye, glm::vec3 origin, glm::vec3 u, glm::vec3 v, GLfloat lod);
+
+#endif
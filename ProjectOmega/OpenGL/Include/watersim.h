@@ -0,0 +1,77 @@
+#ifndef WATERSIM_H
+#define WATERSIM_H
+
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+#include <vector>
+
+#define WATER_SIM_SIZE 256				// heightfield texels a side
+#define WATER_SIM_SIZE_MAX 1024
+#define WATER_SIM_SPEED 0.2f			// wave speed, scene units per second
+#define WATER_SIM_COURANT 0.5f			// texels a wave moves per step (stable up to 1/sqrt(2)), fixes the step rate
+#define WATER_SIM_DECAY 2.f				// seconds for a wave to fall to 1/e of its height
+#define WATER_SIM_MAX_STEPS 32			// steps one run may catch up, a longer stall is skipped
+#define WATER_SIM_DROPS 8				// disturbances a step applies (must match watersim.fsh)
+#define WATER_SIM_UNIT 14				// texture unit of the heightfield
+
+struct WaterDrop {
+	glm::vec2 pos;			// scene x, z
+	GLfloat radius;			// scene units
+	GLfloat height;			// added at the center, negative pushes the surface in
+};
+
+struct WaterObject {
+	/*
+	Something moving through the water: it displaces its volume where it is and gives it back where it was,
+	so only its motion makes waves
+	*/
+	glm::vec2 pos, from;	// latest position, and where the last run left it
+	GLfloat radius, depth;
+	bool placed = false;	// its volume is in the water
+};
+
+struct WaterSim {
+	/*
+	Heightfield water simulated on the GPU
+	Two RG32F textures ping-pong the height (r) and the height one step earlier (g); a step solves the
+	wave equation explicitly, h' = (2h - h_prev + k * laplacian(h)) * damping with k = WATER_SIM_COURANT^2,
+	so the step rate follows from the wave speed and the texel size: a finer grid takes more, shorter steps
+	for the same waves. The damping also settles the surface back to rest height. Clamped fetches make the
+	edges reflecting walls.
+	runWaterSim advances the simulation to the frame's time in whole fixed steps, independent of the frame
+	rate. Drops queued from the CPU go into the next step, up to WATER_SIM_DROPS per step, and moving objects
+	are interpolated over the steps of a run.
+	*/
+	GLuint stepprogram = 0;
+	GLint w_state = -1, w_wave = -1, w_damping = -1, w_drops = -1, w_drop = -1;
+
+	GLsizei size = 0;
+	glm::vec2 origin = glm::vec2(0.f), extent = glm::vec2(1.f);	// scene x, z the heightfield covers
+	GLfloat rate = 0.f;				// steps per second
+	GLfloat damping = 1.f;			// per step
+
+	GLuint fbo[2] = { 0, 0 }, tex[2] = { 0, 0 };
+	int current = 0;				// tex[current] holds the latest step
+	GLuint output = 0;
+
+	double time = -1.0;				// seconds simulated, -1 before the first run
+	std::vector<WaterDrop> drops;	// waiting for the next step
+	std::vector<WaterObject> objects;
+
+	int steps = 0;					// run by the last runWaterSim
+	unsigned long long totalSteps = 0, skippedSteps = 0;
+};
+
+// (re)allocates a size x size heightfield at rest over the scene rectangle origin .. origin + extent (x, z)
+void setupWaterSim(WaterSim & w, GLsizei size, glm::vec2 origin, glm::vec2 extent);
+void releaseWaterSim(WaterSim & w);
+
+void addWaterDrop(WaterSim & w, glm::vec2 pos, GLfloat radius, GLfloat height);
+// returns the object's index for moveWaterObject; it enters the water at its first move
+int addWaterObject(WaterSim & w, GLfloat radius, GLfloat depth);
+void moveWaterObject(WaterSim & w, int object, glm::vec2 pos);
+
+// steps up to time (seconds), w.steps tells how many; leaves the heightfield bound to WATER_SIM_UNIT
+void runWaterSim(WaterSim & w, GLfloat time, GLuint screenVAO);
+
+#endif
@@ -0,0 +1,38 @@
+#ifndef WORKERS_H
+#define WORKERS_H
+
+#include <atomic>
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+struct WorkerPool {
+	/*
+	Threads parked between jobs, for work split every frame
+	parallelFor hands out chunks of a range through an atomic counter; the calling thread takes chunks as
+	well and returns once every chunk is done, so a pool without threads (one hardware thread) simply
+	runs the loop. Only one thread may call parallelFor
+	*/
+	std::vector<std::thread> threads;
+	std::mutex mutex;
+	std::condition_variable wake, done;
+	const std::function<void(int, int)> * job = nullptr;
+	int count = 0, chunk = 1;
+	std::atomic<int> next{ 0 };
+	int busy = 0;					// threads still in the current job
+	unsigned generation = 0;		// bumped per job, a parked thread wakes when it changes
+	bool quit = false;
+
+	~WorkerPool();					// a scene's pool is joined when it goes, running threads would terminate
+};
+
+// threads beside the caller; 0 takes one per hardware thread but the caller's
+void setupWorkerPool(WorkerPool & p, unsigned threads = 0);
+void releaseWorkerPool(WorkerPool & p);
+
+// calls body(begin, end) for consecutive chunks of at most chunk items covering 0..count-1, on every thread of the pool
+void parallelFor(WorkerPool & p, int count, int chunk, const std::function<void(int, int)> & body);
+
+#endif
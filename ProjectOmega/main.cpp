@@ -1,12 +1,20 @@
 #include <glad/glad.h>
 #include <GLFW/glfw3.h>
-#include <iostream>
 #include <fstream>
 #include <string>
 #include <vector>
+#include <glextra.h>
 #include <glutil.h>
+#include <scene.h>
+#include <bench.h>
+#include <resolution.h>
+#include <glstate.h>
+#include <log.h>
 
-#define BLUR_PASSES 10
+#define BLUR_RADIUS legacyBlurSigma(BLUR_PASSES, SCR_WIDTH * LEGACY_BLUR_OFFSET)	// gaussian sigma in pixels of the pyramid blur, defaults to the look of the legacy blur
+#define PROFILE_OUTPUT "frame_stats.csv"		// per-pass GPU/CPU timings (use a .json name for JSON lines)
+#define PROFILE_REPORT_FRAMES 300				// frames between two reports
+#define FRAME_BUDGET_MS 14.f					// GPU time per frame the dynamic resolution keeps under (R key toggles it)
 
 using namespace std;
 
@@ -33,117 +41,40 @@ mouse_lastY = SCR_HEIGHT / 2.f,		// to keep track of mouse position
 yaw = -90.f,						// camera yaw 
 pitch = 0;	// camera pitch
 
-int selection = 1, style = 0;
+int selection = 1, style = WATER_SIM_STYLE;
+int framesInFlight = FRAME_CONTEXTS;				// fewer: less input lag, more: steadier throughput
+GLuint waterResolution = WATER_RESOLUTION;		// quads per side of the bufferless water grid (+ / - keys)
+int waterLod = WATER_LOD_FIXED;					// fixed grid, tessellated or quadtree water (G key), the scene picks the start
+int fbWidth = SCR_WIDTH, fbHeight = SCR_HEIGHT;	// framebuffer size, kept up to date by framebuffer_size_callback
+
+DynamicResolution resolution;
+LogLimit resizeLog = { 1.0 };		// dragging the window edge resizes every frame
 
 bool
+blurDof = false,								// depth of field blends in the blur instead of gathering (V / C keys)
+legacyBlur = false,							// 10-pass full-resolution blur instead of the pyramid (Z / X keys)
+measureBlur = false, measureHeld = false,	// compare the pyramid against the legacy blur once (M key)
+dropWater = false, dropHeld = false,			// drop into the simulated water where the camera looks (space)
+resolutionHeld = false,						// dynamic resolution on/off (R key)
+latencyHeld = false,							// frames in flight 1..FRAME_CONTEXTS_MAX (L key)
+gridHeld = false,								// water grid twice / half as fine (+ / - keys)
+lodHeld = false,								// next way of tessellating the water (G key)
+autofocus = false, autofocusHeld = false,		// focus on the center of the screen (F key), otherwise the focus sweeps
 firstMouse = true, refMode = true;			// fixing the mouse location upon startup (check camera slides)                    // input management (so the key is not repeated until released)
 
-float skybox[] = {
-	// positions          
-	-1.0f,  1.0f, -1.0f,
-	-1.0f, -1.0f, -1.0f,
-	 1.0f, -1.0f, -1.0f,
-	 1.0f, -1.0f, -1.0f,
-	 1.0f,  1.0f, -1.0f,
-	-1.0f,  1.0f, -1.0f,
-
-	-1.0f, -1.0f,  1.0f,
-	-1.0f, -1.0f, -1.0f,
-	-1.0f,  1.0f, -1.0f,
-	-1.0f,  1.0f, -1.0f,
-	-1.0f,  1.0f,  1.0f,
-	-1.0f, -1.0f,  1.0f,
-
-	 1.0f, -1.0f, -1.0f,
-	 1.0f, -1.0f,  1.0f,
-	 1.0f,  1.0f,  1.0f,
-	 1.0f,  1.0f,  1.0f,
-	 1.0f,  1.0f, -1.0f,
-	 1.0f, -1.0f, -1.0f,
-
-	-1.0f, -1.0f,  1.0f,
-	-1.0f,  1.0f,  1.0f,
-	 1.0f,  1.0f,  1.0f,
-	 1.0f,  1.0f,  1.0f,
-	 1.0f, -1.0f,  1.0f,
-	-1.0f, -1.0f,  1.0f,
-
-	-1.0f,  1.0f, -1.0f,
-	 1.0f,  1.0f, -1.0f,
-	 1.0f,  1.0f,  1.0f,
-	 1.0f,  1.0f,  1.0f,
-	-1.0f,  1.0f,  1.0f,
-	-1.0f,  1.0f, -1.0f,
-
-	-1.0f, -1.0f, -1.0f,
-	-1.0f, -1.0f,  1.0f,
-	 1.0f, -1.0f, -1.0f,
-	 1.0f, -1.0f, -1.0f,
-	-1.0f, -1.0f,  1.0f,
-	 1.0f, -1.0f,  1.0f
-};
-
-struct Vertexture {
-	GLfloat x, y, z, s, t;
-};
-
-Vertexture full_screens[] = {
-	{-1, 1, 0, 0, 1},
-	{-1, -1, 0, 0, 0},
-	{1, 1, 0, 1, 1},
-	{1, -1, 0, 1, 0}
-};
-
-vector<string> faces = { "textures/px.jpg", "textures/nx.jpg", "textures/py.jpg", "textures/ny.jpg", "textures/pz.jpg", "textures/nz.jpg" };
-
-GLuint loadCubemap(vector<string> f) {
-	GLuint texID;
-	glGenTextures(1, &texID);
-	glActiveTexture(GL_TEXTURE0);
-	glBindTexture(GL_TEXTURE_CUBE_MAP, texID);
-
-	int width, height, n;
-	for (int i = 0; i < f.size(); i++) {
-		unsigned char *data = stbi_load(f[i].c_str(), &width, &height, &n, 0);
-		
-		if (data)
-		{
-			switch (i)
-			{
-			case 0:
-				glTexImage2D(GL_TEXTURE_CUBE_MAP_POSITIVE_X, 0, GL_RGB, width, height, 0, GL_RGB, GL_UNSIGNED_BYTE, data);
-			case 1:
-				glTexImage2D(GL_TEXTURE_CUBE_MAP_NEGATIVE_X, 0, GL_RGB, width, height, 0, GL_RGB, GL_UNSIGNED_BYTE, data);
-			case 2:
-				glTexImage2D(GL_TEXTURE_CUBE_MAP_POSITIVE_Y, 0, GL_RGB, width, height, 0, GL_RGB, GL_UNSIGNED_BYTE, data);
-			case 3:
-				glTexImage2D(GL_TEXTURE_CUBE_MAP_NEGATIVE_Y, 0, GL_RGB, width, height, 0, GL_RGB, GL_UNSIGNED_BYTE, data);
-			case 4:
-				glTexImage2D(GL_TEXTURE_CUBE_MAP_POSITIVE_Z, 0, GL_RGB, width, height, 0, GL_RGB, GL_UNSIGNED_BYTE, data);
-			case 5:
-				glTexImage2D(GL_TEXTURE_CUBE_MAP_NEGATIVE_Z, 0, GL_RGB, width, height, 0, GL_RGB, GL_UNSIGNED_BYTE, data);
-			default:
-				break;
-			}
-			stbi_image_free(data);
-		}
-		else
-		{
-			std::cout << "Cubemap texture failed to load at path: " << faces[i] << std::endl;
-			stbi_image_free(data);
-		}
-	}
-
-	glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
-	glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
-	glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
-	glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
-	glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_R, GL_CLAMP_TO_EDGE);
+int main(int argc, char ** argv) {
 
-	return texID;
-}
+	BenchOptions bench;
+	bool benchmark = parseBenchArgs(argc, argv, bench);
+	if (bench.usage >= 0) {
+		return bench.usage;
+	}
+	if (benchmark) {
+		return bench.cpu ? runCpuBenchmark(bench) : runBenchmark(bench);
+	}
 
-int main() {
+	// from here on the frame thread only queues messages, a background thread writes them
+	startLogger(LOG_INFO);
 
 	// glfw: initialize and configure
 	// ------------------------------
@@ -156,7 +87,7 @@ int main() {
 	// -------------------- 
 	GLFWwindow* window = glfwCreateWindow(SCR_WIDTH, SCR_HEIGHT, "CS 179.7: DOFDOF", NULL, NULL);
 	if (window == NULL) {
-		std::cout << "Failed to create GLFW window" << std::endl;
+		logMessage(LOG_ERROR, "Failed to create GLFW window");
 		glfwTerminate();
 		return -1;
 	}
@@ -166,521 +97,96 @@ int main() {
 	// glad: load all OpenGL function pointers
 	// ---------------------------------------
 	if (!gladLoadGLLoader((GLADloadproc)glfwGetProcAddress)) {
-		std::cout << "Failed to initialize GLAD" << std::endl;
+		logMessage(LOG_ERROR, "Failed to initialize GLAD");
 		return -1;
 	}
+	loadGLExtras((GLADloadproc)glfwGetProcAddress);
 
 	// OpenGL stuff
 	{						// flip images upon loading (for textures)
 		glfwSetInputMode(window, GLFW_CURSOR, GLFW_CURSOR_DISABLED);	// captures the mouse cursor / hides it when the window is in focus
 		glfwSetCursorPosCallback(window, mouse_callback);				// tell GLFW which method to call whenever the mouse moves
 		glfwSwapInterval(1);											// to keep it simple, makes the perFragment run at 60fps
-		glEnable(GL_DEPTH_TEST);										// enable depth test
-		glEnable(GL_CULL_FACE);											// enable face culling
-		glCullFace(GL_BACK);											// cull back-facing polygons (GL_BACK by default but calling anyway)
-		glEnable(GL_CLIP_DISTANCE0);
-	}
-
-	
-	unsigned int skyboxVAO, skyboxVBO;
-	{
-		glGenVertexArrays(1, &skyboxVAO);
-		glGenBuffers(1, &skyboxVBO);
-		glBindVertexArray(skyboxVAO);
-		glBindBuffer(GL_ARRAY_BUFFER, skyboxVBO);
-		glBufferData(GL_ARRAY_BUFFER, sizeof(skybox), &skybox, GL_STATIC_DRAW);
-		glEnableVertexAttribArray(0);
-		glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 3 * sizeof(float), (void*)0);
-	}
-
-	GLuint sphereVAO, sphereVBO;
-	auto sphere = genSphere(0.1125f, 50);
-	{
-		glGenVertexArrays(1, &sphereVAO);
-		glGenBuffers(1, &sphereVBO);
-		glBindVertexArray(sphereVAO);
-		glBindBuffer(GL_ARRAY_BUFFER, sphereVBO);
-
-		glBufferData(GL_ARRAY_BUFFER, sphere.size() * sizeof(Vertex), sphere.data(), GL_STATIC_DRAW);
-		glEnableVertexAttribArray(0);
-		glEnableVertexAttribArray(1);
-		glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, sizeof(Vertex), 0);
-		glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*)offsetof(Vertex, x1));
-	}
-
-	GLuint cubeVAO, cubeVBO;
-	auto cube = genCube(0.5f, 50);
-	{
-		glGenVertexArrays(1, &cubeVAO);
-		glBindVertexArray(cubeVAO);
-		glGenBuffers(1, &cubeVBO);
-		glBindBuffer(GL_ARRAY_BUFFER, cubeVBO);
-		glBindVertexArray(cubeVAO);
-
-		glBufferData(GL_ARRAY_BUFFER, cube.size() * sizeof(Vertex), cube.data(), GL_STATIC_DRAW);
-		glEnableVertexAttribArray(0);
-		glEnableVertexAttribArray(1);
-		glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, sizeof(Vertex), 0);
-		glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*)offsetof(Vertex, x1));
-	}
-
-	GLuint cubeTexVAO, cubeTexVBO;
-	auto texcube = genTexCube(0.5f, 1);
-	//auto texcube = genTexPlane(glm::vec3(0, 1, 0), glm::vec3(1, 0, 0), glm::vec3(-1, -1, 0), 1);
-	{
-		glGenVertexArrays(1, &cubeTexVAO);
-		glBindVertexArray(cubeTexVAO);
-		glGenBuffers(1, &cubeTexVBO);
-		glBindBuffer(GL_ARRAY_BUFFER, cubeTexVBO);
-		glBindVertexArray(cubeTexVAO);
-
-		glBufferData(GL_ARRAY_BUFFER, texcube.size() * sizeof(NewVertex), texcube.data(), GL_STATIC_DRAW);
-		glEnableVertexAttribArray(0);
-		glEnableVertexAttribArray(1);
-		glEnableVertexAttribArray(2);
-		glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, sizeof(NewVertex), 0);
-		glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, sizeof(NewVertex), (void*)offsetof(NewVertex, x1));
-		glVertexAttribPointer(2, 2, GL_FLOAT, GL_FALSE, sizeof(NewVertex), (void*)offsetof(NewVertex, u));
-	}
-
-	GLuint planeVAO, planeVBO;
-	auto plane = genPlane(glm::vec3(.2, .4, .3), glm::vec3(.3, .4, .2), glm::vec3(0, -.5, 0), 100);
-	{
-		glGenVertexArrays(1, &planeVAO);
-		glBindVertexArray(planeVAO);
-		glGenBuffers(1, &planeVBO);
-		glBindBuffer(GL_ARRAY_BUFFER, planeVBO);
-		glBindVertexArray(planeVAO);
-
-		glBufferData(GL_ARRAY_BUFFER, plane.size() * sizeof(Vertex), plane.data(), GL_STATIC_DRAW);
-		glEnableVertexAttribArray(0);
-		glEnableVertexAttribArray(1);
-		glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, sizeof(Vertex), 0);
-		glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*)offsetof(Vertex, x1));
-	}
-
-	GLuint newPlaneVAO, newPlaneVBO;
-	//auto plane = genPlane(glm::vec3(.2, .4, .3), glm::vec3(.3, .4, .2), glm::vec3(0, -.5, 0), 100);
-	auto newPlane = genTexPlane(glm::vec3(0, 0, .5), glm::vec3(.5, 0, 0), glm::vec3(-.25f, 0.2, -.25f), 100);
-	{
-		glGenVertexArrays(1, &newPlaneVAO);
-		glBindVertexArray(newPlaneVAO);
-		glGenBuffers(1, &newPlaneVBO);
-		glBindBuffer(GL_ARRAY_BUFFER, newPlaneVBO);
-		glBindVertexArray(newPlaneVAO);
-
-		glBufferData(GL_ARRAY_BUFFER, newPlane.size() * sizeof(NewVertex), newPlane.data(), GL_STATIC_DRAW);
-		glEnableVertexAttribArray(0);
-		glEnableVertexAttribArray(1);
-		glEnableVertexAttribArray(2);
-		glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, sizeof(NewVertex), 0);
-		glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, sizeof(NewVertex), (void*)offsetof(NewVertex, x1));
-		glVertexAttribPointer(2, 2, GL_FLOAT, GL_FALSE, sizeof(NewVertex), (void*)offsetof(NewVertex, u));
-	}
-
-	GLuint screenVAO, screenVBO;
-	{
-		glGenVertexArrays(1, &screenVAO);
-		glBindVertexArray(screenVAO);
-		glGenBuffers(1, &screenVBO);
-		glBindBuffer(GL_ARRAY_BUFFER, screenVBO);
-		glBindVertexArray(screenVAO);
-
-		glBufferData(GL_ARRAY_BUFFER, sizeof(full_screens), full_screens, GL_STATIC_DRAW);
-		glEnableVertexAttribArray(0);
-		glEnableVertexAttribArray(1);
-		glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, sizeof(Vertexture), (void*)0);
-		glVertexAttribPointer(1, 2, GL_FLOAT, GL_FALSE, sizeof(Vertexture), (void*)offsetof(Vertexture, s));
-
 	}
-	
-	///====================FRAMEBUFFEROBJECTS=============================
-
-	//generate pristine framebuffer
-	GLuint pristineFbo;
-	{
-		glGenFramebuffers(1, &pristineFbo);
-		glBindFramebuffer(GL_FRAMEBUFFER, pristineFbo);
-	}
-
-	//generate pristine texture
-	GLuint pristineTex;
-	{
-		glGenTextures(1, &pristineTex);
-		glActiveTexture(GL_TEXTURE3);
-		glBindTexture(GL_TEXTURE_2D, pristineTex);
-		glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, SCR_WIDTH, SCR_HEIGHT, 0, GL_RGBA, GL_UNSIGNED_BYTE, 0);
-		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
-		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
-		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
-		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
 
-	}
+	// the framebuffer can be larger than the window (high-DPI displays)
+	glfwGetFramebufferSize(window, &fbWidth, &fbHeight);
 
-	//add pristine texture to framebuffer
-	glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, pristineTex, 0);
-
-	//generate depth texture
-	GLuint depthTex;
-	{
-		glGenTextures(1, &depthTex);
-		glActiveTexture(GL_TEXTURE5);
-		glBindTexture(GL_TEXTURE_2D, depthTex);
-		glTexImage2D(GL_TEXTURE_2D, 0, GL_DEPTH_COMPONENT, SCR_WIDTH, SCR_HEIGHT, 0, GL_DEPTH_COMPONENT, GL_UNSIGNED_BYTE, 0);
-		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
-		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
-		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
-		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
-	}
-
-	//attach depth texture to framebuffer
-	glFramebufferTexture2D(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_TEXTURE_2D, depthTex, 0);
-
-	// check if framebuffer is complete
-	auto status = glCheckFramebufferStatus(GL_FRAMEBUFFER);
-	if (status != GL_FRAMEBUFFER_COMPLETE) {
-		std::cerr << "Cannot setup framebuffer (incomplete): " << status << ".\n";
+	Scene scene;
+	if (!initScene(scene, fbWidth, fbHeight, BLUR_RADIUS, PROFILE_OUTPUT, PROFILE_REPORT_FRAMES)) {
 		return -1;
 	}
+	resolution.budgetMs = FRAME_BUDGET_MS;
+	scene.autofocus.readback = true;		// only for the log line, the renderer never waits on it
+	waterLod = scene.waterLod;
 
-	//generate two FBs for blurring
-	GLuint blur[2];
-	glGenFramebuffers(2, blur);
-
-	//generate two textures for blurring
-	GLuint blurTex[2];
-	glGenTextures(2, blurTex);
-
-	//set active texture
-	glActiveTexture(GL_TEXTURE4);
-
-	//bind both framebuffer and texture, then attach to FB
-	for (int i = 0; i < 2; i++) {
-		glBindFramebuffer(GL_FRAMEBUFFER, blur[i]);
-		glBindTexture(GL_TEXTURE_2D, blurTex[i]);
-		glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, SCR_WIDTH, SCR_HEIGHT, 0, GL_RGBA, GL_UNSIGNED_BYTE, 0);
-		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
-		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
-		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
-		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
-		glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, blurTex[i], 0);
-
-		// check again if framebuffer is complete
-		auto status = glCheckFramebufferStatus(GL_FRAMEBUFFER);
-		if (status != GL_FRAMEBUFFER_COMPLETE) {
-			std::cerr << "Cannot setup framebuffer (incomplete): " << status << ".\n";
-			return -1;
-		}
-	}
-
-	// generate and bind framebuffer to store area under the pool
-	GLuint refractFbo;
-	{
-		glGenFramebuffers(1, &refractFbo);
-		glBindFramebuffer(GL_FRAMEBUFFER, refractFbo);
-	}
-
-	// generate refraction texture
-	GLuint refractTex;
-	{
-		glGenTextures(1, &refractTex);
-		glActiveTexture(GL_TEXTURE8);
-		glBindTexture(GL_TEXTURE_2D, refractTex);
-		glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, SCR_WIDTH, SCR_HEIGHT, 0, GL_RGBA, GL_UNSIGNED_BYTE, 0);
-		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
-		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
-		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
-		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
-	}
-
-	// add refractTex to refractFbo
-	glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, refractTex, 0);
-
-	///loading programs 
-
-	//skybox
-	GLuint sbox = loadCubemap(faces);
-
-	GLuint dudvmap;
-	loadTexture(&dudvmap, 6, "textures/dudv.jpg");
-
-	GLuint pooltex;
-	loadTexture(&pooltex, 7, "textures/bathroom_tiles.jpg");
-
-	GLuint caust1, caust2, caust3, caust4, caust5;
-	loadTexture(&caust1, 9, "textures/caust_001.png");
-	loadTexture(&caust2, 10, "textures/caust_002.png");
-	loadTexture(&caust3, 11, "textures/caust_003.png");
-	loadTexture(&caust4, 12, "textures/caust_004.png");
-	loadTexture(&caust5, 13, "textures/caust_005.png");
-	
-	//SB program
-	auto skyboxprogram = loadProgram("shaders/skybox.vsh", "shaders/skybox.fsh");
-	auto s_cube = glGetUniformLocation(skyboxprogram, "skybox");
-	auto s_view = glGetUniformLocation(skyboxprogram, "view");
-	auto s_proj = glGetUniformLocation(skyboxprogram, "projection");
-
-	glUseProgram(skyboxprogram);
-	glUniform1i(s_cube, 0);
-
-	//render programs
-	GLuint sphereprogram = loadProgram("shaders/reflect.vsh", "shaders/reflect.gsh", "shaders/reflect.fsh");
-
-	GLuint u_cube, u_model, u_view, u_proj, u_eyepos, u_lightpos, u_lightcolor, u_dudv, u_pooltex, u_poolnorm, u_time, u_style;
-	{
-		u_cube = glGetUniformLocation(sphereprogram, "skybox");
-		u_model = glGetUniformLocation(sphereprogram, "model");
-		u_view = glGetUniformLocation(sphereprogram, "view");
-		u_proj = glGetUniformLocation(sphereprogram, "projection");
-		u_eyepos = glGetUniformLocation(sphereprogram, "eye_pos");
-		u_lightpos = glGetUniformLocation(sphereprogram, "lightpos");
-		u_lightcolor = glGetUniformLocation(sphereprogram, "lightcolor");
-		u_dudv = glGetUniformLocation(sphereprogram, "dudv");
-		u_pooltex = glGetUniformLocation(sphereprogram, "pooltex");
-		u_poolnorm = glGetUniformLocation(sphereprogram, "poolnorm");
-		u_time = glGetUniformLocation(sphereprogram, "time");
-		u_style = glGetUniformLocation(sphereprogram, "style");
-	}
-
-	GLuint transprogram = loadProgram("shaders/refract.vsh", "shaders/refract.fsh");
-
-	GLuint t_model, t_view, t_proj, t_eyepos, t_cube, t_time, t_style, t_pooltex;
-	{
-		t_model = glGetUniformLocation(transprogram, "model");
-		t_view = glGetUniformLocation(transprogram, "view");
-		t_proj = glGetUniformLocation(transprogram, "proj");
-		t_eyepos = glGetUniformLocation(transprogram, "eye_pos");
-		t_cube = glGetUniformLocation(transprogram, "skybox");
-		t_time = glGetUniformLocation(transprogram, "time");
-		t_style = glGetUniformLocation(transprogram, "style");
-		t_pooltex = glGetUniformLocation(transprogram, "pooltex");
-	}
-
-
-	//blur program
-	GLuint frameprogram = loadProgram("shaders/frame.vsh", "shaders/frame.fsh");
-	auto f_frametex = glGetUniformLocation(frameprogram, "frametex"); //source texture for blurring
-	
-	glUseProgram(frameprogram);
-	glUniform1i(f_frametex, 3);
-
-	//combine program
-	GLuint combineprogram = loadProgram("shaders/frame.vsh", "shaders/combine.fsh");
-	GLuint c_pristineTex, c_blurTex, c_depthTex, c_focus, c_selection;
-	{
-		c_pristineTex = glGetUniformLocation(combineprogram, "pristineTex");
-		c_blurTex = glGetUniformLocation(combineprogram, "blurTex");
-		c_depthTex = glGetUniformLocation(combineprogram, "depthTex");
-		c_focus = glGetUniformLocation(combineprogram, "focus");
-		c_selection = glGetUniformLocation(combineprogram, "selection");
-	}
-
-	glUseProgram(combineprogram);
-	
-	// set up Uniform1i's
-	glUniform1i(c_pristineTex, 3);
-	glUniform1i(c_blurTex, 4);
-	glUniform1i(c_depthTex, 5);
-
-	GLuint poolprogram = loadProgram("shaders/plain.vsh", "shaders/plain.fsh");
-	GLuint p_model, p_view, p_proj, p_pool_tex, p_clipping_plane, p_time, p_caust1, p_caust2, p_caust3, p_caust4, p_caust5;
-	{
-		p_model = glGetUniformLocation(poolprogram, "model");
-		p_view = glGetUniformLocation(poolprogram, "view");
-		p_proj = glGetUniformLocation(poolprogram, "projection");
-		p_pool_tex = glGetUniformLocation(poolprogram, "poolTexture");
-		p_clipping_plane = glGetUniformLocation(poolprogram, "clipping_plane");
-		p_time = glGetUniformLocation(poolprogram, "time");
-
-		p_caust1 = glGetUniformLocation(poolprogram, "caustics[0]");
-		p_caust2 = glGetUniformLocation(poolprogram, "caustics[1]");
-		p_caust3 = glGetUniformLocation(poolprogram, "caustics[2]");
-		p_caust4 = glGetUniformLocation(poolprogram, "caustics[3]");
-		p_caust5 = glGetUniformLocation(poolprogram, "caustics[4]");
-	}
-	
-	glUseProgram(poolprogram);
-	glUniform1i(p_pool_tex, 7);
-	glUniform1i(p_caust1, 9);
-	glUniform1i(p_caust2, 10);
-	glUniform1i(p_caust3, 11);
-	glUniform1i(p_caust4, 12);
-	glUniform1i(p_caust5, 13);
-
-	glm::vec3 lightpos(-0.3, 0.7, -0.2);
-	glm::vec3 lightcol(1, 1, 1);
-
-	int t = 0;
+	GLState reported = glState;		// counters at the last report
 
 	/// render loop
 	while (!glfwWindowShouldClose(window)) {
 		processInput(window);
 
-		// configuring matrices
-		glm::mat4 view, proj;
-		view = glm::lookAt(cameraPos, cameraPos + cameraFront, cameraUp);
-		proj = glm::perspective(glm::radians(45.f), (float)(SCR_WIDTH / SCR_HEIGHT), .1f, 100.f);
-
-		// render the pool to a framebuffer bound to a refractTex
-		{
-			glBindFramebuffer(GL_FRAMEBUFFER, refractFbo);
-			glClearColor(0.1f, 0.3f, 0.5f, 1.0f);
-			glEnable(GL_DEPTH_TEST);
-			glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
-
-			// pool
-			{
-				glFrontFace(GL_CW);
-				glm::mat4 model = glm::mat4(1.f);
-				glUseProgram(poolprogram);
-				glUniformMatrix4fv(p_model, 1, GL_FALSE, glm::value_ptr(model));
-				glUniformMatrix4fv(p_view, 1, GL_FALSE, glm::value_ptr(view));
-				glUniformMatrix4fv(p_proj, 1, GL_FALSE, glm::value_ptr(proj));
-				glUniform4fv(p_clipping_plane, 1, glm::value_ptr(glm::vec4(0, -1, 0, .2)));
-				glUniform1i(p_time, t);
-
-				glBindVertexArray(cubeTexVAO);
-				glDrawArrays(GL_TRIANGLE_STRIP, 0, texcube.size());
-				glFrontFace(GL_CCW);
-			}
+		FrameParams frame;
+		frame.cameraPos = cameraPos;
+		frame.cameraFront = cameraFront;
+		frame.cameraUp = cameraUp;
+		frame.time = glfwGetTime();
+		frame.selection = selection;
+		frame.style = style;
+		frame.blurDof = blurDof;
+		frame.autofocus = autofocus;
+		frame.legacyBlur = legacyBlur;
+		frame.measureBlur = measureBlur;
+		measureBlur = false;
+
+		if (dropWater && cameraFront.y < 0.f && cameraPos.y > scene.waterMin.y) {
+			// where the view ray meets the water plane from above, twice the size of the rain
+			glm::vec3 at = cameraPos + cameraFront * ((scene.waterMin.y - cameraPos.y) / cameraFront.y);
+			addWaterDrop(scene.sim, glm::vec2(at.x, at.z), 2.f * WATER_DROP_RADIUS, 2.f * WATER_DROP_HEIGHT);
 		}
-
-		//bind pristineFbo and render
-		{
-			glBindFramebuffer(GL_FRAMEBUFFER, pristineFbo);
-			glClearColor(0.1f, 0.3f, 0.5f, 1.0f);
-			glEnable(GL_DEPTH_TEST);
-			glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
-
-			// water plane
-			{
-				glDisable(GL_CULL_FACE);
-				glm::mat4 model = glm::mat4(1.f);
-				// model = glm::scale(model, glm::vec3(1.f, 0.8f, 1.f));
-				// model = glm::rotate(model, 90.f * PI / 180.f, glm::vec3(1.f, 0.f, 0.f));
-				glUseProgram(sphereprogram);
-				glUniformMatrix4fv(u_model, 1, GL_FALSE, glm::value_ptr(model));
-				glUniformMatrix4fv(u_view, 1, GL_FALSE, glm::value_ptr(view));
-				glUniformMatrix4fv(u_proj, 1, GL_FALSE, glm::value_ptr(proj));
-				glUniform3fv(u_eyepos, 1, (GLfloat*)& cameraPos);
-				glUniform3fv(u_lightpos, 1, (GLfloat*)& cameraPos);
-				glUniform3fv(u_lightcolor, 1, (GLfloat*)& lightcol);
-				
-
-				glUniform1i(u_style, style);
-				
-				glUniform1f(u_time, glfwGetTime());
-
-				glUniform1i(u_pooltex, 8);
-				glBindTexture(GL_TEXTURE_CUBE_MAP, sbox);
-				glBindVertexArray(newPlaneVAO);
-				glDrawArrays(GL_TRIANGLE_STRIP, 0, newPlane.size());
-				glEnable(GL_CULL_FACE);
-			}
-
-			// pool
-			{
-				glFrontFace(GL_CW);
-				glm::mat4 model = glm::mat4(1.f);
-				glUseProgram(poolprogram);
-				glUniformMatrix4fv(p_model, 1, GL_FALSE, glm::value_ptr(model));
-				glUniformMatrix4fv(p_view, 1, GL_FALSE, glm::value_ptr(view));
-				glUniformMatrix4fv(p_proj, 1, GL_FALSE, glm::value_ptr(proj));
-				glUniform4fv(p_clipping_plane, 1, glm::value_ptr(glm::vec4(0, 0, 0, 0)));
-				glUniform1i(p_time, t);
-
-				glBindVertexArray(cubeTexVAO);
-				glDrawArrays(GL_TRIANGLE_STRIP, 0, texcube.size());
-				glFrontFace(GL_CCW);
-			}
-
-			//skybox
-			{
-				glDepthFunc(GL_LEQUAL);
-				glUseProgram(skyboxprogram);
-				view = glm::mat4(glm::mat3(glm::lookAt(cameraPos, cameraPos + cameraFront, cameraUp)));
-				glUniformMatrix4fv(s_view, 1, GL_FALSE, glm::value_ptr(view));
-				glUniformMatrix4fv(s_proj, 1, GL_FALSE, glm::value_ptr(proj));
-
-				glBindVertexArray(skyboxVAO);
-				glDrawArrays(GL_TRIANGLES, 0, 36);
-				glDepthFunc(GL_LESS);
-			}
+		dropWater = false;
+		if (waterResolution != scene.waterResolution) {
+			scene.waterResolution = waterResolution;
+			logMessage(LOG_INFO, "Water grid: %ux%u quads", waterResolution, waterResolution);
 		}
-
-		//perform blurring
-		{
-
-			glBindFramebuffer(GL_FRAMEBUFFER, blur[0]);
-			glActiveTexture(GL_TEXTURE3);
-			glBindTexture(GL_TEXTURE_2D, pristineTex);
-
-			glDisable(GL_DEPTH_TEST);
-			glBindVertexArray(screenVAO);
-
-			glUseProgram(frameprogram);
-			glBindVertexArray(screenVAO);
-
-			glDrawArrays(GL_TRIANGLE_STRIP, 0, 4);
-
-			for (int i = 1; i < BLUR_PASSES; i++) {
-				glBindTexture(GL_TEXTURE_2D, 0);
-				glBindFramebuffer(GL_FRAMEBUFFER, blur[i % 2]);
-				glBindTexture(GL_TEXTURE_2D, blurTex[(i + 1) % 2]);
-				glDrawArrays(GL_TRIANGLE_STRIP, 0, 4);
-			}
+		if (waterLod != scene.waterLod) {
+			static const char * lods[WATER_LOD_MODES] = { "fixed grid", "tessellated", "quadtree" };
+			scene.waterLod = waterLod;
+			logMessage(LOG_INFO, "Water: %s", lods[waterLod]);
 		}
-
-		//combine
-		{
-			glBindFramebuffer(GL_FRAMEBUFFER, 0);
-			glActiveTexture(GL_TEXTURE3);
-			glBindTexture(GL_TEXTURE_2D, pristineTex);
-
-			glActiveTexture(GL_TEXTURE4);
-			glBindTexture(GL_TEXTURE_2D, blurTex[(BLUR_PASSES + 1) % 2]);
-
-			glActiveTexture(GL_TEXTURE5);
-			glBindTexture(GL_TEXTURE_2D, depthTex);
-
-			glClear(GL_COLOR_BUFFER_BIT);
-
-			glBindVertexArray(screenVAO);
-			glUseProgram(combineprogram);
-			glUniform1i(c_selection, selection);
-			glUniform1f(c_focus, sin(0.75 * glfwGetTime()) + 0.5);
-
-			glDrawArrays(GL_TRIANGLE_STRIP, 0, 4);
+		if (framesInFlight != scene.pacer.frames) {
+			setFramesInFlight(scene.pacer, framesInFlight);
+			logMessage(LOG_INFO, "Frames in flight: %d", scene.pacer.frames);
+		}
+		renderScene(scene, frame, 0);
+		if (scene.profiler.frame % PROFILE_REPORT_FRAMES == 0) {
+			if (autofocus) {
+				logMessage(LOG_INFO, "Autofocus: %g", scene.autofocus.focus);
+			}
+			logMessage(LOG_INFO, "GL state: %u calls/frame, %u redundant ones skipped", (glState.calls - reported.calls) / PROFILE_REPORT_FRAMES,
+				(glState.skipped - reported.skipped) / PROFILE_REPORT_FRAMES);
+			reported = glState;
+			logMessage(LOG_INFO, "%d frames in flight: CPU waited %.3f ms/frame, GPU idle %.3f ms/frame", scene.pacer.frames,
+				scene.pacer.waitMs / glm::max(scene.pacer.waits, 1u), scene.pacer.idleMs / glm::max(scene.pacer.idles, 1u));
+			resetFramePacerStats(scene.pacer);
 		}
-
 
 		glfwSwapBuffers(window);
 		glfwPollEvents();
 
+		// follow the window and the frame time; targets are only reallocated when the render size changes
+		GLfloat scale = updateDynamicResolution(resolution, scene.profiler.latestFrameMs);
+		if (fbWidth > 0 && fbHeight > 0 && (fbWidth != scene.width || fbHeight != scene.height || scale != scene.renderScale)) {
+			if (!resizeScene(scene, fbWidth, fbHeight, scale)) {
+				break;
+			}
+			logLimited(resizeLog, LOG_INFO, "Render size %dx%d for %dx%d", scene.renderWidth, scene.renderHeight, fbWidth, fbHeight);
+		}
+
 		// update timers for the camera
 		GLfloat currentTime = glfwGetTime();
 		deltaTime = currentTime - lastFrame;
 		lastFrame = currentTime;
-
-		float plan = glfwGetTime() - floor(glfwGetTime());
-
-		cout << plan << endl;
-
-		//for texture timing
-		if (plan < 0.2) {
-			t = 0;
-		} else if (plan < 0.4) {
-			t = 1;
-		}
-		else if (plan < 0.6) {
-			t = 2;
-		}
-		else if (plan < 0.8) {
-			t = 3;
-		}
-		else if(plan < 1.0) {
-			t = 4;
-		}
 	}
 
 	// glfw: terminate, clearing all previously allocated GLFW resources.
@@ -704,14 +210,92 @@ void processInput(GLFWwindow *window) {
 		style = 1;
 	if (glfwGetKey(window, GLFW_KEY_E) == GLFW_PRESS)
 		style = 2;
+	if (glfwGetKey(window, GLFW_KEY_T) == GLFW_PRESS)
+		style = WATER_SIM_STYLE;
+	if (glfwGetKey(window, GLFW_KEY_Y) == GLFW_PRESS)
+		style = WATER_OCEAN_STYLE;
+	if (glfwGetKey(window, GLFW_KEY_C) == GLFW_PRESS)
+		blurDof = false;
+	if (glfwGetKey(window, GLFW_KEY_V) == GLFW_PRESS)
+		blurDof = true;
+	if (glfwGetKey(window, GLFW_KEY_Z) == GLFW_PRESS)
+		legacyBlur = false;
+	if (glfwGetKey(window, GLFW_KEY_X) == GLFW_PRESS)
+		legacyBlur = true;
+	if (glfwGetKey(window, GLFW_KEY_M) == GLFW_PRESS) {
+		measureBlur = !measureHeld;
+		measureHeld = true;
+	}
+	else {
+		measureHeld = false;
+	}
+	if (glfwGetKey(window, GLFW_KEY_SPACE) == GLFW_PRESS) {
+		dropWater = !dropHeld;
+		dropHeld = true;
+	}
+	else {
+		dropHeld = false;
+	}
+	if (glfwGetKey(window, GLFW_KEY_F) == GLFW_PRESS) {
+		if (!autofocusHeld) {
+			autofocus = !autofocus;
+		}
+		autofocusHeld = true;
+	}
+	else {
+		autofocusHeld = false;
+	}
+	if (glfwGetKey(window, GLFW_KEY_R) == GLFW_PRESS) {
+		if (!resolutionHeld) {
+			resolution.budgetMs = resolution.budgetMs > 0.f ? 0.f : FRAME_BUDGET_MS;
+			resolution.scale = resolution.maxScale;
+			resolution.samples = 0;
+		}
+		resolutionHeld = true;
+	}
+	else {
+		resolutionHeld = false;
+	}
+	if (glfwGetKey(window, GLFW_KEY_L) == GLFW_PRESS) {
+		if (!latencyHeld) {
+			framesInFlight = framesInFlight % FRAME_CONTEXTS_MAX + 1;
+		}
+		latencyHeld = true;
+	}
+	else {
+		latencyHeld = false;
+	}
+	if (glfwGetKey(window, GLFW_KEY_EQUAL) == GLFW_PRESS || glfwGetKey(window, GLFW_KEY_MINUS) == GLFW_PRESS) {
+		if (!gridHeld) {
+			waterResolution = glfwGetKey(window, GLFW_KEY_EQUAL) == GLFW_PRESS ? glm::min(waterResolution * 2, GLuint(WATER_RESOLUTION_MAX))
+				: glm::max(waterResolution / 2, 1u);
+		}
+		gridHeld = true;
+	}
+	else {
+		gridHeld = false;
+	}
+	if (glfwGetKey(window, GLFW_KEY_G) == GLFW_PRESS) {
+		if (!lodHeld) {
+			waterLod = (waterLod + 1) % WATER_LOD_MODES;
+			if (waterLod == WATER_LOD_TESS && !glExtras.tessellation) {
+				waterLod = WATER_LOD_QUADTREE;
+			}
+		}
+		lodHeld = true;
+	}
+	else {
+		lodHeld = false;
+	}
 	if (glfwGetKey(window, GLFW_KEY_ESCAPE) == GLFW_PRESS)
 		exit(0);
 }
 // glfw: whenever the window size changed (by OS or user resize) this callback function executes
 void framebuffer_size_callback(GLFWwindow* window, int width, int height) {
-	// make sure the viewport matches the new window dimensions; note that width and 
+	// the render loop resizes the scene's targets before the next frame; note that width and
 	// height will be significantly larger than specified on retina displays.
-	glViewport(0, 0, width, height);
+	fbWidth = width;
+	fbHeight = height;
 }
 
 // called whenever the mouse moves
@@ -738,11 +322,5 @@ void mouse_callback(GLFWwindow* window, double xpos, double ypos) {
 	pitch = pitch > 89.f ? 89.f : pitch;
 	pitch = pitch < -89.f ? -89.f : pitch;
 
-	glm::vec3 front;
-	front.x = cos(glm::radians(pitch)) * cos(glm::radians(yaw));
-	front.y = sin(glm::radians(pitch));
-	front.z = cos(glm::radians(pitch)) * sin(glm::radians(yaw));
-	cameraFront = glm::normalize(front);
-
-	cameraPos = -cameraFront;
+	orbitCamera(yaw, pitch, cameraFront, cameraPos);
 }
\ No newline at end of file
@@ -0,0 +1,17 @@
+// std140 blocks shared by every shader, mirrored by PerFrame / PerDraw in OpenGL/Include/uniforms.h
+
+layout(std140) uniform PerFrame {
+	mat4 view;
+	mat4 projection;
+	vec3 eye_pos;
+	float time;
+	vec3 lightpos;
+	float focus;
+	vec3 lightcolor;
+	float pad0;
+};
+
+layout(std140) uniform PerDraw {
+	mat4 model;
+	vec4 clipping_plane;
+};
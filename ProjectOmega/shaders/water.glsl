@@ -0,0 +1,64 @@
+// the water surface of every way the grid is drawn: displaces a point of the flat water by the style and
+// writes what reflect.fsh reads. Needs uniforms.glsl and the o_pos / o_normals / clipSpace outputs
+
+// STYLE picks the water (keys Q/W/E/T/Y): 0 waves along z, 1 waves along x, 2 an expanding ring,
+// 3 the simulated heightfield (WaterSim), 4 the FFT ocean (Ocean)
+#ifndef STYLE
+#define STYLE 3
+#endif
+
+#if STYLE == 3
+uniform sampler2D heightfield;		// r: height in scene units
+#elif STYLE == 4
+uniform sampler2D displacement;		// x, height and z displacement in scene units, tiling
+uniform sampler2D normals;			// x and z slope
+#endif
+#if STYLE >= 3
+uniform vec4 heightfield_rect;		// x, z of the corner of one tile and its size along x, z
+#endif
+
+void waterSurface(vec3 v_pos, vec3 v_normals) {
+	vec3 temp_pos = v_pos;
+	vec3 slope = vec3(0.0);		// derivative of the displacement along x and z
+#if STYLE == 0
+	{
+		temp_pos.y += sin(temp_pos.z * 100 + time * 10) / 50;
+		slope.z = cos(v_pos.z * 100 + time * 10) * 2;
+	}
+#elif STYLE == 1
+	{
+		temp_pos.y -= sin(temp_pos.x * 100 + time * 10) / 50;
+		slope.x = -cos(v_pos.x * 100 + time * 10) * 2;
+	}
+#elif STYLE == 3
+	{
+		// central differences one texel apart, bilinear between the texels
+		vec2 uv = (v_pos.xz - heightfield_rect.xy) / heightfield_rect.zw;
+		vec2 texel = 1.0 / vec2(textureSize(heightfield, 0));
+		temp_pos.y += textureLod(heightfield, uv, 0.0).r;
+		slope.x = (textureLod(heightfield, uv + vec2(texel.x, 0.0), 0.0).r - textureLod(heightfield, uv - vec2(texel.x, 0.0), 0.0).r)
+			/ (2.0 * texel.x * heightfield_rect.z);
+		slope.z = (textureLod(heightfield, uv + vec2(0.0, texel.y), 0.0).r - textureLod(heightfield, uv - vec2(0.0, texel.y), 0.0).r)
+			/ (2.0 * texel.y * heightfield_rect.w);
+	}
+#elif STYLE == 4
+	{
+		vec2 uv = (v_pos.xz - heightfield_rect.xy) / heightfield_rect.zw;
+		temp_pos += textureLod(displacement, uv, 0.0).xyz;
+		slope.xz = textureLod(normals, uv, 0.0).xy;
+	}
+#else
+	{
+		// inside the ring (plus a 0.03 margin) the water sits a step lower
+		float ring = length(temp_pos.xz) - sin(time) / 4;
+		if (ring < 0.03)
+			temp_pos.y -= 0.01;
+	}
+#endif
+
+	o_pos = vec3(model * vec4(temp_pos, 1.0));
+	// normal of the surface y + h(x, z) is (-dh/dx, 1, -dh/dz); the rings are flat between their steps
+	o_normals = normalize(mat3(model) * (normalize(v_normals) - slope));
+	gl_Position = projection * view * model * vec4(v_pos, 1.0);
+	clipSpace = gl_Position;
+}
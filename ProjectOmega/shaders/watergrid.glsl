@@ -0,0 +1,53 @@
+// bufferless water grid: one instance per row of quads, each a triangle strip of 2 * (resolution + 1)
+// vertices, top edge first like genTexPlane's strip. Mirrored by WaterGrid in OpenGL/Include/uniforms.h
+// The same block describes the patches of the tessellated water (watertess.*) and the nodes of the
+// quadtree (WaterLod), resolution then being the patches per side and the quads per node side
+
+layout(std140) uniform WaterGrid {
+	vec3 grid_origin;		// corner at column 0, row 0
+	int grid_resolution;	// quads per side
+	vec3 grid_u;			// the whole grid along the columns
+	float grid_lod;			// pixels per radian over the target spacing: a length times this over its distance is in target spacings
+	vec3 grid_v;			// the whole grid along the rows
+	float grid_morph;		// part of a quadtree node's range over which its vertices morph to its parent's grid
+};
+
+// the tessellation stages only read the block
+#ifndef WATER_GRID_BLOCK_ONLY
+
+void waterGridVertex(out vec3 pos, out vec3 normal, out vec2 uv) {
+	int col = gl_VertexID >> 1;
+	int row = gl_InstanceID + 1 - (gl_VertexID & 1);
+	float n = float(grid_resolution);
+	vec3 du = grid_u / n, dv = grid_v / n;
+	pos = du * float(col) + dv * float(row) + grid_origin;
+	normal = normalize(cross(du, dv));
+	uv = vec2(col, row) / n;
+}
+
+void waterPatchCorner(out vec3 pos) {
+	// four vertices per patch, the rows of patches one after the other
+	int quad = gl_VertexID >> 2;
+	int col = quad % grid_resolution + (gl_VertexID & 1);
+	int row = quad / grid_resolution + ((gl_VertexID >> 1) & 1);
+	pos = grid_origin + (grid_u * float(col) + grid_v * float(row)) / float(grid_resolution);
+}
+
+void waterNodeVertex(vec4 node, vec3 eye, out vec3 pos, out vec3 normal, out vec2 uv) {
+	/*
+	node: corner and size as fractions of the grid, and the distance where its vertices have become its
+	parent's. One strip for all rows, joined by repeating the last vertex of a row and the first of the next.
+	Past the start of the morph the odd vertices slide onto their even neighbours, so at the range a node
+	meets a coarser neighbour with exactly that neighbour's vertices
+	*/
+	int n = grid_resolution, strip = 2 * n + 4;
+	int i = clamp(gl_VertexID % strip - 1, 0, 2 * n + 1);
+	vec2 cell = vec2(i >> 1, gl_VertexID / strip + 1 - (i & 1));
+	uv = node.xy + cell * (node.z / float(n));
+	float distance = length(grid_origin + grid_u * uv.x + grid_v * uv.y - eye);
+	float morph = clamp((distance / node.w - 1.0) / grid_morph + 1.0, 0.0, 1.0);
+	uv -= mod(cell, 2.0) * morph * (node.z / float(n));
+	pos = grid_origin + grid_u * uv.x + grid_v * uv.y;
+	normal = normalize(cross(grid_u, grid_v));
+}
+#endif
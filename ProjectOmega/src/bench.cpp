@@ -0,0 +1,703 @@
+#include <bench.h>
+#include <glextra.h>
+#include <glutil.h>
+#include <glstate.h>
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <numeric>
+#include <iostream>
+
+// offscreen contexts come from EGL where the build found it (Mesa llvmpipe needs no GPU), otherwise from a hidden GLFW window
+#ifdef OMEGA_EGL
+#include <EGL/egl.h>
+#include <EGL/eglext.h>
+#else
+#include <GLFW/glfw3.h>
+#endif
+
+static const char * benchUsage =
+	"usage: --bench | --cpu, and any of\n"
+	"  --frames N, --warmup N, --frames-in-flight N, --size WxH, --scale S, --budget MS, --refract-scale S, --no-refract-cull, --no-compute,\n"
+	"  --water-mesh, --water-resolution N (0: the bound of --lod-pixels), --water-lod fixed|tess|quadtree, --lod-pixels N, --match-error E,\n"
+	"  --water-sim N, --ocean-size N, --ocean-gpu, --caustics-grid N, --caustics-size N,\n"
+	"  --f-number N, --autofocus, --focus-region X,Y,W,H, --style 0-4, --selection 1-4, --blur-dof, --legacy-blur (implies --blur-dof), --measure-blur,\n"
+	"  --stats FILE, --dump FILE.ppm, --help\n";
+
+bool parseBenchArgs(int argc, char ** argv, BenchOptions & o) {
+	/*
+	Returns true if --bench or --cpu was given and reads the options of benchUsage. --help, an unknown
+	argument or value print the usage and set o.usage to the exit code instead of running with defaults
+	*/
+	bool bench = false;
+	for (int i = 1; i < argc; i++) {
+		std::string a = argv[i];
+		bool more = i + 1 < argc;
+		if (a == "--bench") bench = true;
+		else if (a == "--cpu") bench = o.cpu = true;
+		else if (a == "--frames" && more) o.frames = atoi(argv[++i]);
+		else if (a == "--warmup" && more) o.warmup = atoi(argv[++i]);
+		else if (a == "--frames-in-flight" && more) o.framesInFlight = atoi(argv[++i]);
+		else if (a == "--size" && more) sscanf(argv[++i], "%dx%d", &o.width, &o.height);
+		else if (a == "--scale" && more) o.renderScale = atof(argv[++i]);
+		else if (a == "--budget" && more) o.budgetMs = atof(argv[++i]);
+		else if (a == "--refract-scale" && more) o.refractScale = atof(argv[++i]);
+		else if (a == "--no-refract-cull") o.refractCull = false;
+		else if (a == "--no-compute") o.compute = false;
+		else if (a == "--water-mesh") o.waterGrid = false;
+		else if (a == "--water-resolution" && more) o.waterResolution = atoi(argv[++i]);
+		else if (a == "--water-lod" && more) {
+			std::string lod = argv[++i];
+			o.waterLod = lod == "fixed" ? WATER_LOD_FIXED : lod == "tess" ? WATER_LOD_TESS : lod == "quadtree" ? WATER_LOD_QUADTREE : -1;
+			if (o.waterLod < 0) {
+				std::cerr << "Unknown water LOD " << lod << std::endl;
+				o.usage = 1;
+			}
+		}
+		else if (a == "--lod-pixels" && more) o.lodPixels = atof(argv[++i]);
+		else if (a == "--match-error" && more) o.matchError = atof(argv[++i]);
+		else if (a == "--water-sim" && more) o.waterSim = atoi(argv[++i]);
+		else if (a == "--ocean-size" && more) o.oceanSize = atoi(argv[++i]);
+		else if (a == "--ocean-gpu") o.oceanGpu = true;
+		else if (a == "--caustics-grid" && more) o.causticsGrid = atoi(argv[++i]);
+		else if (a == "--caustics-size" && more) o.causticsSize = atoi(argv[++i]);
+		else if (a == "--f-number" && more) o.fNumber = atof(argv[++i]);
+		else if (a == "--autofocus") o.autofocus = true;
+		else if (a == "--focus-region" && more) {
+			sscanf(argv[++i], "%f,%f,%f,%f", &o.focusRegion[0], &o.focusRegion[1], &o.focusRegion[2], &o.focusRegion[3]);
+			o.autofocus = true;
+		}
+		else if (a == "--style" && more) {
+			// wrapped into 0..WATER_STYLES-1 here, the scene indexes its programs with it
+			o.style = (atoi(argv[++i]) % WATER_STYLES + WATER_STYLES) % WATER_STYLES;
+		}
+		else if (a == "--selection" && more) o.selection = atoi(argv[++i]);
+		else if (a == "--blur-dof") o.blurDof = true;
+		else if (a == "--legacy-blur") o.legacyBlur = o.blurDof = true;
+		else if (a == "--measure-blur") o.measureBlur = true;
+		else if (a == "--stats" && more) o.output = argv[++i];
+		else if (a == "--dump" && more) o.dump = argv[++i];
+		else if (a == "--help" || a == "-h") o.usage = glm::max(o.usage, 0);
+		else {
+			std::cerr << "Unknown argument " << a << std::endl;
+			o.usage = 1;
+		}
+	}
+	if (o.usage >= 0) {
+		std::cerr << benchUsage;
+	}
+	return bench;
+}
+
+FrameParams benchFrame(const BenchOptions & o, int frame) {
+	/*
+	Deterministic replacement for mouse_callback and the clock: one full turn of yaw over the run,
+	a slow pitch swing between -30 and 30 degrees, and 60 simulated frames per second
+	*/
+	GLfloat phase = GLfloat(frame) / glm::max(o.frames, 1);
+	GLfloat yaw = -90.f + 360.f * phase;
+	GLfloat pitch = 30.f * sin(2.f * PI * phase);
+
+	FrameParams f;
+	orbitCamera(yaw, pitch, f.cameraFront, f.cameraPos);
+	f.cameraUp = glm::vec3(0.f, 1.f, 0.f);
+	f.time = frame / 60.f;
+	f.selection = o.selection;
+	f.style = o.style;
+	f.blurDof = o.blurDof;
+	f.autofocus = o.autofocus;
+	f.legacyBlur = o.legacyBlur;
+	f.measureBlur = false;
+	return f;
+}
+
+#ifdef OMEGA_EGL
+bool createOffscreenContext(const BenchOptions & o) {
+	/*
+	GL 3.3 core context without a window: EGL surfaceless if the driver has it, else a pbuffer
+	*/
+	auto getPlatformDisplay = (PFNEGLGETPLATFORMDISPLAYEXTPROC)eglGetProcAddress("eglGetPlatformDisplayEXT");
+	EGLDisplay display = EGL_NO_DISPLAY;
+	bool surfaceless = false;
+	if (getPlatformDisplay) {
+		display = getPlatformDisplay(EGL_PLATFORM_SURFACELESS_MESA, EGL_DEFAULT_DISPLAY, NULL);
+		surfaceless = display != EGL_NO_DISPLAY;
+	}
+	if (display == EGL_NO_DISPLAY) {
+		display = eglGetDisplay(EGL_DEFAULT_DISPLAY);
+	}
+
+	EGLint major, minor;
+	if (display == EGL_NO_DISPLAY || !eglInitialize(display, &major, &minor)) {
+		std::cout << "Failed to initialize EGL" << std::endl;
+		return false;
+	}
+
+	EGLint configAttribs[] = {
+		EGL_SURFACE_TYPE, EGL_PBUFFER_BIT,
+		EGL_RENDERABLE_TYPE, EGL_OPENGL_BIT,
+		EGL_RED_SIZE, 8, EGL_GREEN_SIZE, 8, EGL_BLUE_SIZE, 8,
+		EGL_NONE
+	};
+	EGLConfig config;
+	EGLint configs = 0;
+	eglChooseConfig(display, configAttribs, &config, 1, &configs);
+	if (configs == 0 && !surfaceless) {
+		std::cout << "No EGL config for an OpenGL pbuffer" << std::endl;
+		return false;
+	}
+
+	eglBindAPI(EGL_OPENGL_API);
+	EGLint contextAttribs[] = {
+		EGL_CONTEXT_MAJOR_VERSION, 3,
+		EGL_CONTEXT_MINOR_VERSION, 3,
+		EGL_CONTEXT_OPENGL_PROFILE_MASK, EGL_CONTEXT_OPENGL_CORE_PROFILE_BIT,
+		EGL_NONE
+	};
+	EGLContext context = eglCreateContext(display, configs ? config : (EGLConfig)0, EGL_NO_CONTEXT, contextAttribs);
+	if (context == EGL_NO_CONTEXT) {
+		std::cout << "Failed to create EGL context" << std::endl;
+		return false;
+	}
+
+	EGLSurface surface = EGL_NO_SURFACE;
+	if (!surfaceless) {
+		EGLint pbufferAttribs[] = { EGL_WIDTH, o.width, EGL_HEIGHT, o.height, EGL_NONE };
+		surface = eglCreatePbufferSurface(display, config, pbufferAttribs);
+	}
+	if (!eglMakeCurrent(display, surface, surface, context)) {
+		std::cout << "Failed to make the EGL context current" << std::endl;
+		return false;
+	}
+
+	if (!gladLoadGLLoader((GLADloadproc)eglGetProcAddress)) {
+		std::cout << "Failed to initialize GLAD" << std::endl;
+		return false;
+	}
+	loadGLExtras((GLADloadproc)eglGetProcAddress);
+	return true;
+}
+#else
+bool createOffscreenContext(const BenchOptions & o) {
+	/*
+	No EGL: an invisible GLFW window with vsync off stands in for the offscreen context
+	*/
+	glfwInit();
+	glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 3);
+	glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 3);
+	glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
+	glfwWindowHint(GLFW_VISIBLE, GLFW_FALSE);
+	GLFWwindow* window = glfwCreateWindow(o.width, o.height, "bench", NULL, NULL);
+	if (window == NULL) {
+		std::cout << "Failed to create GLFW window" << std::endl;
+		glfwTerminate();
+		return false;
+	}
+	glfwMakeContextCurrent(window);
+	glfwSwapInterval(0);
+
+	if (!gladLoadGLLoader((GLADloadproc)glfwGetProcAddress)) {
+		std::cout << "Failed to initialize GLAD" << std::endl;
+		return false;
+	}
+	loadGLExtras((GLADloadproc)glfwGetProcAddress);
+	return true;
+}
+#endif
+
+std::vector<unsigned char> readFramebuffer(GLuint fbo, GLsizei width, GLsizei height) {
+	std::vector<unsigned char> pixels(width * height * 3);
+	glBindFramebuffer(GL_READ_FRAMEBUFFER, fbo);
+	glPixelStorei(GL_PACK_ALIGNMENT, 1);
+	glReadPixels(0, 0, width, height, GL_RGB, GL_UNSIGNED_BYTE, pixels.data());
+	invalidateGLState();
+	return pixels;
+}
+
+void dumpFramebuffer(GLuint fbo, GLsizei width, GLsizei height, const std::string & path) {
+	/*
+	Writes the color attachment of fbo to a binary PPM (rows flipped so the image is upright)
+	*/
+	std::vector<unsigned char> pixels = readFramebuffer(fbo, width, height);
+
+	FILE * out = fopen(path.c_str(), "wb");
+	if (!out) {
+		std::cerr << "Cannot write " << path << std::endl;
+		return;
+	}
+	fprintf(out, "P6\n%d %d\n255\n", width, height);
+	for (GLsizei row = height - 1; row >= 0; row--) {
+		fwrite(&pixels[row * width * 3], 1, width * 3, out);
+	}
+	fclose(out);
+}
+
+double percentile(std::vector<double> sorted, double p) {
+	if (sorted.empty()) {
+		return 0.0;
+	}
+	std::sort(sorted.begin(), sorted.end());
+	size_t i = size_t(std::ceil(p * sorted.size()));
+	return sorted[i == 0 ? 0 : i - 1];
+}
+
+struct WaterError {
+	double error = 0.0;			// mean absolute difference from the reference, in levels of an 8-bit channel
+	double triangles = 0.0;		// drawn by the water per frame (GL_PRIMITIVES_GENERATED)
+};
+
+static WaterError renderWaterSamples(Scene & scene, const BenchOptions & o, GLuint fbo, std::vector<unsigned char> & reference) {
+	/*
+	Renders the sharp image of BENCH_ERROR_FRAMES frames spread over the camera path and compares them
+	with reference, or fills it when empty. The simulation restarts each time so every call sees the same water
+	*/
+	int samples = glm::min(BENCH_ERROR_FRAMES, glm::max(o.frames, 1));
+	size_t frameBytes = size_t(o.width) * o.height * 3;
+	bool fill = reference.empty();
+	setupWaterSim(scene.sim, scene.sim.size, scene.sim.origin, scene.sim.extent);
+	scene.rainDrops = 0;
+	glGenQueries(1, &scene.waterQuery);
+
+	WaterError e;
+	unsigned long long difference = 0;
+	for (int k = 0; k < samples; k++) {
+		FrameParams f = benchFrame(o, k * o.frames / samples);
+		f.selection = 1;
+		renderScene(scene, f, fbo);
+		GLuint primitives = 0;
+		glGetQueryObjectuiv(scene.waterQuery, GL_QUERY_RESULT, &primitives);
+		e.triangles += primitives;
+
+		std::vector<unsigned char> pixels = readFramebuffer(fbo, o.width, o.height);
+		if (fill) {
+			reference.insert(reference.end(), pixels.begin(), pixels.end());
+			continue;
+		}
+		const unsigned char * r = &reference[k * frameBytes];
+		for (size_t i = 0; i < frameBytes; i++) {
+			difference += abs(int(pixels[i]) - int(r[i]));
+		}
+	}
+	glDeleteQueries(1, &scene.waterQuery);
+	scene.waterQuery = 0;
+	e.error = double(difference) / (double(frameBytes) * samples);
+	e.triangles /= samples;
+	return e;
+}
+
+static int matchWaterError(Scene & scene, const BenchOptions & o, GLuint fbo) {
+	/*
+	Finds for each way of drawing the water the coarsest setting whose image is within o.matchError of a
+	WATER_RESOLUTION_MAX grid: the resolution of the fixed grid, --lod-pixels of the adaptive ones, each by
+	bisection (error falls with the resolution and grows with the pixels). Then times the camera path at
+	that setting, so the triangles and the milliseconds compare at the same measured error rather than at
+	the same bound
+	*/
+	scene.waterGrid = true;
+	scene.waterLod = WATER_LOD_FIXED;
+	scene.waterResolution = WATER_RESOLUTION_MAX;
+	std::vector<unsigned char> reference;
+	renderWaterSamples(scene, o, fbo, reference);
+
+	printf("water LOD at a mean error of %g levels against a %dx%d grid over %d frames\n", o.matchError,
+		WATER_RESOLUTION_MAX, WATER_RESOLUTION_MAX, glm::min(BENCH_ERROR_FRAMES, glm::max(o.frames, 1)));
+	printf("%-10s %12s %8s %12s %10s %10s\n", "lod", "setting", "error", "triangles", "ms/frame", "water gpu");
+	const char * names[] = { "fixed", "tess", "quadtree" };
+	for (int lod = WATER_LOD_FIXED; lod <= WATER_LOD_QUADTREE; lod++) {
+		if (lod == WATER_LOD_TESS && !glExtras.tessellation) {
+			printf("%-10s no GL 4.0 tessellation\n", names[lod]);
+			continue;
+		}
+		scene.waterLod = lod;
+		if (lod == WATER_LOD_FIXED) {
+			GLuint lo = 1, hi = WATER_RESOLUTION_MAX;
+			while (lo < hi) {
+				scene.waterResolution = (lo + hi) / 2;
+				if (renderWaterSamples(scene, o, fbo, reference).error <= o.matchError) {
+					hi = scene.waterResolution;
+				}
+				else {
+					lo = scene.waterResolution + 1;
+				}
+			}
+			scene.waterResolution = hi;
+		}
+		else {
+			// in octaves of pixels from 1/4 to 64
+			GLfloat lo = -2.f, hi = 6.f;
+			for (int i = 0; i < 8; i++) {
+				scene.waterLodPixels = exp2((lo + hi) * .5f);
+				if (renderWaterSamples(scene, o, fbo, reference).error <= o.matchError) {
+					lo = (lo + hi) * .5f;
+				}
+				else {
+					hi = (lo + hi) * .5f;
+				}
+			}
+			scene.waterLodPixels = exp2(lo);
+		}
+		WaterError e = renderWaterSamples(scene, o, fbo, reference);
+
+		std::vector<double> frameMs;
+		auto last = std::chrono::steady_clock::now();
+		for (int i = -o.warmup; i < o.frames; i++) {
+			if (i == 0) {
+				profilerFinish(scene.profiler);
+				profilerReset(scene.profiler);
+				last = std::chrono::steady_clock::now();
+			}
+			renderScene(scene, benchFrame(o, glm::max(i, 0)), fbo);
+			auto now = std::chrono::steady_clock::now();
+			if (i >= 0) {
+				frameMs.push_back(std::chrono::duration<double, std::milli>(now - last).count());
+			}
+			last = now;
+		}
+		glFinish();
+		profilerFinish(scene.profiler);
+
+		char setting[32];
+		if (lod == WATER_LOD_FIXED) {
+			snprintf(setting, sizeof(setting), "%ux%u", scene.waterResolution, scene.waterResolution);
+		}
+		else {
+			snprintf(setting, sizeof(setting), "%.3g px", scene.waterLodPixels);
+		}
+		printf("%-10s %12s %8.3f %12.0f %10.3f %10.3f\n", names[lod], setting, e.error, e.triangles, percentile(frameMs, 0.5),
+			passStats(scene.profiler.passes[scene.pass_water].gpuMs).avg);
+		if (e.error > o.matchError) {
+			printf("%-10s does not reach %g levels, its finest setting above\n", names[lod], o.matchError);
+		}
+	}
+	return 0;
+}
+
+int runBenchmark(const BenchOptions & o) {
+	/*
+	Renders o.frames frames of the full pipeline offscreen along the scripted camera path and reports
+	throughput, ms/frame percentiles and the per-pass timings of the profiler
+	*/
+	if (!createOffscreenContext(o)) {
+		return -1;
+	}
+	std::cout << "Renderer: " << glGetString(GL_RENDERER) << " (" << glGetString(GL_VERSION) << ")" << std::endl;
+
+	Scene scene;
+	GLfloat radius = o.blurRadius > 0.f ? o.blurRadius : legacyBlurSigma(BLUR_PASSES, o.width * LEGACY_BLUR_OFFSET);
+	auto setup = std::chrono::steady_clock::now();
+	if (!initScene(scene, o.width, o.height, radius, o.output, 0)) {
+		return -1;
+	}
+	glFinish();
+	printf("initScene: %.1f ms\n", std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - setup).count());
+
+	DynamicResolution resolution;
+	resolution.budgetMs = o.budgetMs;
+	resolution.scale = resolution.maxScale = o.renderScale;
+	scene.refractScale = o.refractScale;
+	scene.refractCull = o.refractCull;
+	scene.pyramid.compute = scene.dof.compute = o.compute;
+	scene.waterGrid = o.waterGrid;
+	scene.waterResolution = glm::max(o.waterResolution, 1);
+	if (o.waterLod >= 0) {
+		scene.waterLod = o.waterLod;
+	}
+	scene.waterLodPixels = o.lodPixels;
+	if (o.waterSim != scene.sim.size) {
+		setupWaterSim(scene.sim, o.waterSim, scene.sim.origin, scene.sim.extent);
+	}
+	if (o.oceanSize != scene.ocean.size || o.oceanGpu != scene.ocean.gpu) {
+		setupOcean(scene.ocean, o.oceanSize, scene.ocean.extent, o.oceanGpu);
+	}
+	scene.caustics.grid = glm::max(o.causticsGrid, 1);
+	if (o.causticsSize != scene.caustics.size) {
+		setupCaustics(scene.caustics, o.causticsSize, scene.caustics.rect, scene.caustics.floor);
+	}
+	scene.dof.fNumber = o.fNumber;
+	scene.autofocus.readback = o.autofocus;
+	if (o.focusRegion[2] > 0.f) {
+		std::copy(o.focusRegion, o.focusRegion + 4, scene.autofocus.region);
+	}
+	scene.renderWidth = 0;		// reallocate even at the same render size, the refraction scale and the lens may differ
+	if (!resizeScene(scene, o.width, o.height, o.renderScale)) {
+		return -1;
+	}
+	setFramesInFlight(scene.pacer, o.framesInFlight);
+	if (o.waterResolution <= 0) {
+		// a uniform grid has to be as fine everywhere as the adaptive ones are at the nearest water of the run
+		GLfloat lod = scene.renderHeight / (2.f * tan(glm::radians(FOV_Y) * .5f)) / o.lodPixels;
+		GLuint matched = 1;
+		for (int i = 0; i < o.frames; i++) {
+			matched = glm::max(matched, waterLodResolution(benchFrame(o, i).cameraPos, scene.waterOrigin, scene.waterU, scene.waterV, lod));
+		}
+		scene.waterResolution = glm::min(matched, GLuint(WATER_RESOLUTION_MAX));
+	}
+
+	// the window's back buffer: the combine pass writes here
+	GLuint combineFbo, combineTex;
+	makeBlurTarget(&combineFbo, &combineTex, o.width, o.height);
+	invalidateGLState();
+	if (o.matchError > 0.f) {
+		return matchWaterError(scene, o, combineFbo);
+	}
+
+	std::vector<double> frameMs;
+	frameMs.reserve(o.frames);
+	double scaleSum = 0.0;
+	int resizes = 0;
+	GLState counted;
+	unsigned long long simSteps = 0;
+
+	auto start = std::chrono::steady_clock::now();
+	auto last = start;
+	for (int i = -o.warmup; i < o.frames; i++) {
+		if (i == 0) {
+			profilerFinish(scene.profiler);
+			profilerReset(scene.profiler);
+			counted = glState;
+			resetFramePacerStats(scene.pacer);
+			simSteps = scene.sim.totalSteps;
+			resetOceanStats(scene.ocean);
+			start = last = std::chrono::steady_clock::now();
+		}
+
+		// paced like a swap chain by the scene's frame contexts
+		renderScene(scene, benchFrame(o, glm::max(i, 0)), combineFbo);
+		if (i >= 0) {
+			scaleSum += scene.renderScale;
+		}
+
+		GLfloat scale = updateDynamicResolution(resolution, scene.profiler.latestFrameMs);
+		if (scale != scene.renderScale) {
+			if (!resizeScene(scene, o.width, o.height, scale)) {
+				return -1;
+			}
+			resizes += i >= 0;
+		}
+
+		auto now = std::chrono::steady_clock::now();
+		if (i >= 0) {
+			frameMs.push_back(std::chrono::duration<double, std::milli>(now - last).count());
+		}
+		last = now;
+	}
+	glFinish();
+	double total = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+	profilerFinish(scene.profiler);
+
+	printf("%d frames at %dx%d in %.3f s: %.2f frames/s\n", o.frames, o.width, o.height, total, o.frames / total);
+	printf("render scale avg %.3f, last %.2f (%dx%d), %d resizes\n", scaleSum / glm::max(o.frames, 1), scene.renderScale,
+		scene.renderWidth, scene.renderHeight, resizes);
+	printf("ms/frame  min %.3f  p50 %.3f  p90 %.3f  p99 %.3f  max %.3f\n",
+		percentile(frameMs, 0.0), percentile(frameMs, 0.5), percentile(frameMs, 0.9), percentile(frameMs, 0.99), percentile(frameMs, 1.0));
+	unsigned calls = glState.calls - counted.calls, skipped = glState.skipped - counted.skipped;
+	const FramePacer & pacer = scene.pacer;
+	printf("%d frames in flight: CPU waited %.3f ms/frame, GPU idle %.3f ms/frame\n", pacer.frames,
+		pacer.waitMs / glm::max(pacer.waits, 1u), pacer.idleMs / glm::max(pacer.idles, 1u));
+	printf("GL state: %.1f calls/frame, %.1f redundant ones skipped (%.0f%%)\n", GLfloat(calls) / glm::max(o.frames, 1),
+		GLfloat(skipped) / glm::max(o.frames, 1), 100.f * skipped / glm::max(calls + skipped, 1u));
+	printf("%-14s %10s %10s %10s %10s %10s\n", "pass", "gpu min", "gpu avg", "gpu p99", "cpu avg", "cpu p99");
+	for (PassTimer & t : scene.profiler.passes) {
+		PassStats g = passStats(t.gpuMs), c = passStats(t.cpuMs);
+		printf("%-14s %10.3f %10.3f %10.3f %10.3f %10.3f\n", t.name.c_str(), g.min, g.avg, g.p99, c.avg, c.p99);
+	}
+	PassStats g = passStats(scene.profiler.frameMs), c = passStats(scene.profiler.frameCpuMs);
+	printf("%-14s %10.3f %10.3f %10.3f %10.3f %10.3f\n", "frame", g.min, g.avg, g.p99, c.avg, c.p99);
+
+	printf("frame graph: %d passes, %d culled, %zu textures, %.1f MB (%.1f MB unaliased)\n", int(scene.graph.passes.size()),
+		scene.graph.culled, scene.graph.pool.size(), scene.graph.bytes / 1048576.0, scene.graph.unaliasedBytes / 1048576.0);
+	if (scene.waterGrid && scene.waterLod == WATER_LOD_TESS) {
+		printf("water: %dx%d patches tessellated to vertices at most %g pixels apart\n", WATER_TESS_PATCHES, WATER_TESS_PATCHES, scene.waterLodPixels);
+	}
+	else if (scene.waterGrid && scene.waterLod == WATER_LOD_QUADTREE) {
+		printf("water: quadtree of %zu %dx%d nodes in the last frame, %d levels, vertices at most %g pixels apart, %u splits over %d nodes skipped\n",
+			scene.lod.nodes.size(), WATER_LOD_NODE, WATER_LOD_NODE, scene.lod.depth + 1, scene.waterLodPixels, scene.lod.skipped, WATER_LOD_NODES_MAX);
+	}
+	else if (scene.waterGrid) {
+		printf("water: bufferless %ux%u grid, %u triangles\n", scene.waterResolution, scene.waterResolution, 2 * scene.waterResolution * scene.waterResolution);
+	}
+	else {
+		printf("water: %zu vertices (%zu KB) and %zu indices from buffers\n", scene.newPlane.vertices.size(),
+			scene.newPlane.vertices.size() * sizeof(NewVertex) / 1024, scene.newPlane.indices.size());
+	}
+	if (o.style % WATER_STYLES == WATER_SIM_STYLE) {
+		// the pass only runs steps, so its time over the steps of the run is the cost of one
+		const PassTimer & t = scene.profiler.passes[scene.pass_watersim];
+		double steps = double(std::max(scene.sim.totalSteps - simSteps, 1ull));
+		printf("water simulation: %dx%d at %.1f steps/s, %.2f steps/frame, %.3f ms/step GPU, %.3f ms/step CPU, %llu steps skipped\n",
+			scene.sim.size, scene.sim.size, scene.sim.rate, steps / glm::max(o.frames, 1),
+			std::accumulate(t.gpuMs.begin(), t.gpuMs.end(), 0.0) / steps, std::accumulate(t.cpuMs.begin(), t.cpuMs.end(), 0.0) / steps,
+			scene.sim.skippedSteps);
+	}
+	if (o.style % WATER_STYLES == WATER_OCEAN_STYLE) {
+		const Ocean & ocean = scene.ocean;
+		PassStats g = passStats(scene.profiler.passes[scene.pass_ocean].gpuMs), c = passStats(scene.profiler.passes[scene.pass_ocean].cpuMs);
+		printf("ocean: %dx%d FFT on the %s, %.3f ms/frame GPU, %.3f ms/frame CPU\n", ocean.size, ocean.size,
+			ocean.gpu ? "GPU (--ocean-gpu)" : "CPU", g.avg, c.avg);
+		if (!ocean.gpu) {
+			unsigned runs = glm::max(ocean.runs, 1u);
+			printf("ocean CPU: %zu worker threads and this one, %s butterflies, spectrum %.3f ms, transforms %.3f ms, packing %.3f ms, %u uploads waited\n",
+				scene.workers.threads.size(), oceanSse() ? "SSE2" : "scalar", ocean.spectrumMs / runs, ocean.fftMs / runs, ocean.packMs / runs, ocean.stalls);
+		}
+	}
+	{
+		PassStats g = passStats(scene.profiler.passes[scene.pass_caustics].gpuMs);
+		printf("caustics: %ux%u light grid (%u triangles) into %dx%d texels, %.3f ms/frame GPU\n", scene.caustics.grid, scene.caustics.grid,
+			2 * scene.caustics.grid * scene.caustics.grid, scene.caustics.size, scene.caustics.size, g.avg);
+	}
+	printf("blur and dof gather: %s\n", blurPyramidCompute(scene.pyramid) ? "compute shaders" :
+		glExtras.compute ? "fragment shaders (--no-compute)" : "fragment shaders (no GL 4.3 compute)");
+	printf("dof: %.1f%% of %dx%d tiles sharp in the last frame\n", 100.f * dofSharpTiles(scene.dof), scene.dof.tilesX, scene.dof.tilesY);
+	if (o.autofocus) {
+		printf("autofocus: %.3f, %u readbacks, %u not ready in time\n", scene.autofocus.focus, scene.autofocus.reads, scene.autofocus.misses);
+	}
+
+	writeProfilerReport(scene.profiler);
+
+	{
+		// one more frame counting what the water draws, outside the timed run
+		glGenQueries(1, &scene.waterQuery);
+		renderScene(scene, benchFrame(o, o.frames - 1), combineFbo);
+		GLuint primitives = 0;
+		glGetQueryObjectuiv(scene.waterQuery, GL_QUERY_RESULT, &primitives);
+		glDeleteQueries(1, &scene.waterQuery);
+		scene.waterQuery = 0;
+		printf("water: %u triangles in the last frame (GL_PRIMITIVES_GENERATED)\n", primitives);
+	}
+	if (o.measureBlur) {
+		// one more frame with both blurs, outside the timed run
+		FrameParams f = benchFrame(o, o.frames - 1);
+		f.measureBlur = true;
+		renderScene(scene, f, combineFbo);
+	}
+	if (!o.dump.empty()) {
+		dumpFramebuffer(combineFbo, o.width, o.height, o.dump);
+	}
+	return 0;
+}
+
+template <typename F>
+static void timeCpu(const char * name, int reps, int iters, F body) {
+	/*
+	Runs body iters times per repetition and prints the fastest and the median repetition, per call
+	*/
+	std::vector<double> us;
+	for (int r = 0; r < reps; r++) {
+		auto start = std::chrono::steady_clock::now();
+		for (int i = 0; i < iters; i++) {
+			body();
+		}
+		us.push_back(std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - start).count() / iters);
+	}
+	printf("%-28s %8d %12.3f %12.3f\n", name, iters, percentile(us, 0.0), percentile(us, 0.5));
+}
+
+int runCpuBenchmark(const BenchOptions & o) {
+	/*
+	Times the CPU-side pieces of scene setup and transforms in isolation, no GL context needed:
+	the mesh generators at the resolutions initScene uses, the image decode behind loadTexture, Matrix4 multiply
+	a frame of the CPU ocean at each size and the water quadtree's selection
+	*/
+	int reps = glm::max(o.frames / 60, 5);
+	volatile size_t sink = 0;		// keeps the results alive so the calls are not optimized out
+	printf("%-28s %8s %12s %12s\n", "function", "iters", "us min", "us p50");
+
+	timeCpu("genPlane 100", reps, 20, [&] {
+		sink += genPlane(glm::vec3(.2, .4, .3), glm::vec3(.3, .4, .2), glm::vec3(0, -.5, 0), 100).size();
+	});
+	timeCpu("genTexPlane 100", reps, 20, [&] {
+		sink += genTexPlane(glm::vec3(0, 0, .5), glm::vec3(.5, 0, 0), glm::vec3(-.25f, 0.2, -.25f), 100).size();
+	});
+	timeCpu("genSphere 50", reps, 20, [&] {
+		sink += genSphere(0.1125f, 50).size();
+	});
+	timeCpu("genCube 50", reps, 5, [&] {
+		sink += genCube(0.5f, 50).size();
+	});
+
+	timeCpu("genIndexedPlane 100", reps, 20, [&] {
+		sink += genIndexedPlane(glm::vec3(.2, .4, .3), glm::vec3(.3, .4, .2), glm::vec3(0, -.5, 0), 100).indices.size();
+	});
+	timeCpu("genIndexedTexPlane 100", reps, 20, [&] {
+		sink += genIndexedTexPlane(glm::vec3(0, 0, .5), glm::vec3(.5, 0, 0), glm::vec3(-.25f, 0.2, -.25f), 100).indices.size();
+	});
+	timeCpu("genIndexedSphere 50", reps, 20, [&] {
+		sink += genIndexedSphere(0.1125f, 50).indices.size();
+	});
+	timeCpu("genIndexedCube 50", reps, 5, [&] {
+		sink += genIndexedCube(0.5f, 50).indices.size();
+	});
+
+	const char * images[] = { "textures/bathroom_tiles.jpg", "textures/dudv.jpg", "textures/caust_001.png", "textures/px.jpg" };
+	for (const char * file : images) {
+		std::string name = std::string("stbi_load ") + (strrchr(file, '/') + 1);
+		timeCpu(name.c_str(), glm::max(reps / 4, 3), 1, [&] {
+			int w = 0, h = 0, n = 0;
+			unsigned char * data = stbi_load(file, &w, &h, &n, 0);
+			if (!data) {
+				std::cerr << "Cannot decode " << file << std::endl;
+				return;
+			}
+			sink += w * h * n;
+			stbi_image_free(data);
+		});
+	}
+
+	Matrix4 m = rotate(translate(Matrix4(), .1f, .2f, .3f), 30.f, 0.f, 1.f, 0.f);
+	Matrix4 acc;
+	timeCpu("multiply(Matrix4, Matrix4)", reps, 100000, [&] {
+		acc = multiply(acc, m);
+	});
+	Vector4 v(1.f, 2.f, 3.f, 1.f);
+	timeCpu("multiply(Matrix4, Vector4)", reps, 100000, [&] {
+		v = multiply(m, v);
+	});
+	sink += size_t(acc.data[0] + v.x);
+
+	WorkerPool workers;
+	setupWorkerPool(workers);
+	for (GLsizei n = 128; n <= OCEAN_SIZE_MAX; n *= 2) {
+		Ocean ocean;
+		setupOceanSpectrum(ocean, n, 1.f);
+		std::vector<GLfloat> out(6 * size_t(n) * n);
+		std::string name = "simulateOcean " + std::to_string(n);
+		GLfloat time = 0.f;
+		timeCpu(name.c_str(), reps, 4, [&] {
+			simulateOcean(ocean, workers, time += 1.f / 60.f, out.data());
+		});
+		sink += size_t(out[0]);
+	}
+	printf("(ocean on %zu worker threads and this one, %s butterflies)\n", workers.threads.size(), oceanSse() ? "SSE2" : "scalar");
+
+	// the water's quadtree from the top and the bottom of the bench's orbit, 1000 pixels high
+	WaterLod lod;
+	GLfloat pixelsPerRadian = 1000.f / (2.f * tan(glm::radians(FOV_Y) * .5f));
+	glm::vec3 waterOrigin(-.25f, 0.2, -.25f), waterU(0, 0, .5), waterV(.5, 0, 0);
+	for (GLfloat pitch : { 30.f, -30.f }) {
+		glm::vec3 front, eye;
+		orbitCamera(-90.f, pitch, front, eye);
+		std::string name = "selectWaterLod pitch " + std::to_string(int(pitch));
+		timeCpu(name.c_str(), reps, 1000, [&] {
+			selectWaterLod(lod, eye, waterOrigin, waterU, waterV, pixelsPerRadian / WATER_LOD_PIXELS);
+		});
+		sink += lod.nodes.size();
+	}
+
+	// vertex shader runs: every strip vertex is shaded once, indexed meshes go through a FIFO of VERTEX_CACHE_SIZE
+	printf("\n%-20s %8s %8s %10s %8s %8s\n", "mesh", "strip", "unique", "triangles", "ACMR", "ATVR");
+	auto meshStats = [](const char * name, size_t strip, size_t unique, const std::vector<GLuint> & indices) {
+		CacheStats c = cacheStats(indices, unique);
+		printf("%-20s %8zu %8zu %10zu %8.3f %8.3f\n", name, strip, unique, indices.size() / 3, c.acmr, c.atvr);
+	};
+	IndexedMesh<NewVertex> water = genIndexedTexPlane(glm::vec3(0, 0, .5), glm::vec3(.5, 0, 0), glm::vec3(-.25f, 0.2, -.25f), 100);
+	meshStats("water plane 100", genTexPlane(glm::vec3(0, 0, .5), glm::vec3(.5, 0, 0), glm::vec3(-.25f, 0.2, -.25f), 100).size(), water.vertices.size(), water.indices);
+	IndexedMesh<Vertex> sphere = genIndexedSphere(0.1125f, 50);
+	meshStats("sphere 50", genSphere(0.1125f, 50).size(), sphere.vertices.size(), sphere.indices);
+	IndexedMesh<NewVertex> pool = genIndexedTexCube(0.5f, 1);
+	meshStats("pool 1", genTexCube(0.5f, 1).size(), pool.vertices.size(), pool.indices);
+	return 0;
+}
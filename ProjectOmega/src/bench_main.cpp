@@ -0,0 +1,10 @@
+#include <bench.h>
+
+int main(int argc, char ** argv) {
+	BenchOptions o;
+	parseBenchArgs(argc, argv, o);
+	if (o.usage >= 0) {
+		return o.usage;
+	}
+	return o.cpu ? runCpuBenchmark(o) : runBenchmark(o);
+}
@@ -0,0 +1,260 @@
+#include <blur.h>
+#include <glextra.h>
+#include <glstate.h>
+#include <log.h>
+#include <shaders.h>
+#include <glm/glm.hpp>
+#include <algorithm>
+
+GLfloat legacyBlurSigma(int passes, GLfloat offset) {
+	/*
+	Returns the gaussian sigma (in pixels) that the old ping-pong blur converges to
+	passes -> number of full-screen passes of the 3x3 [1 2 1] kernel
+	offset -> tap distance in pixels (frame.fsh uses 1/300 of the screen)
+	Each pass adds the variance of the binomial kernel plus the bilinear spread of the fractional offset
+	*/
+	GLfloat f = offset - floor(offset);
+	GLfloat variance = 0.5f * (offset * offset + f * (1.f - f));
+	return sqrt(passes * variance);
+}
+
+void makeBlurTarget(GLuint * fbo, GLuint * tex, GLsizei w, GLsizei h) {
+	glGenFramebuffers(1, fbo);
+	glGenTextures(1, tex);
+	glBindFramebuffer(GL_FRAMEBUFFER, *fbo);
+	glBindTexture(GL_TEXTURE_2D, *tex);
+	glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA8, w, h, 0, GL_RGBA, GL_UNSIGNED_BYTE, 0);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+	glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, *tex, 0);
+
+	auto status = glCheckFramebufferStatus(GL_FRAMEBUFFER);
+	if (status != GL_FRAMEBUFFER_COMPLETE) {
+		logMessage(LOG_ERROR, "Cannot setup blur framebuffer (incomplete): %u.", status);
+	}
+}
+
+void releaseBlurPyramid(BlurPyramid & b) {
+	for (size_t i = 0; i < b.fbo.size(); i++) {
+		if (b.fbo[i]) glDeleteFramebuffers(1, &b.fbo[i]);
+		if (b.tex[i]) glDeleteTextures(1, &b.tex[i]);
+	}
+	b.fbo.clear();
+	b.tex.clear();
+	if (b.scratchFbo) glDeleteFramebuffers(1, &b.scratchFbo);
+	if (b.scratchTex) glDeleteTextures(1, &b.scratchTex);
+	b.scratchFbo = b.scratchTex = 0;
+}
+
+void setupBlurPyramid(BlurPyramid & b, GLsizei width, GLsizei height, GLfloat radius) {
+	/*
+	(Re)allocates the pyramid for a source of width x height and a target gaussian sigma of radius pixels
+	The level count is picked so the remaining sigma at the smallest level stays around 1.5-3 texels,
+	which keeps the separable kernel within BLUR_MAX_TAPS bilinear taps per side
+	*/
+	releaseBlurPyramid(b);
+	b.width = width;
+	b.height = height;
+	b.radius = radius;
+
+	b.levels = 0;
+	while (radius / GLfloat(2 << b.levels) >= 1.5f && (width >> (b.levels + 1)) >= 8 && (height >> (b.levels + 1)) >= 8) {
+		b.levels++;
+	}
+
+	// every box downsample into scale s adds s*s/16 and every bilinear upsample out of scale s adds 3*s*s/16
+	// (variance in source pixels), which sums to (4^levels - 1) / 3 over the whole chain
+	GLfloat scale = GLfloat(1 << b.levels);
+	GLfloat fixed = (scale * scale - 1.f) / 3.f;
+	GLfloat sigma = sqrt(glm::max(radius * radius - fixed, 0.f)) / scale;
+
+	// discrete gaussian, then pairs of neighbouring texels are merged into one bilinear fetch
+	int support = glm::min(int(ceil(3.f * sigma)), 2 * BLUR_MAX_TAPS);
+	std::vector<GLfloat> w(support + 1);
+	GLfloat sum = 0.f;
+	for (int i = 0; i <= support; i++) {
+		w[i] = sigma > 0.f ? exp(-0.5f * i * i / (sigma * sigma)) : (i == 0 ? 1.f : 0.f);
+		sum += i == 0 ? w[i] : 2.f * w[i];
+	}
+	b.support = support;
+	for (int i = 0; i <= support; i++) {
+		b.kernel[i] = w[i] / sum;
+	}
+	b.weights[0] = w[0] / sum;
+	b.offsets[0] = 0.f;
+	b.taps = 0;
+	for (int i = 1; i <= support; i += 2) {
+		GLfloat w0 = w[i], w1 = i + 1 <= support ? w[i + 1] : 0.f;
+		b.taps++;
+		b.weights[b.taps] = (w0 + w1) / sum;
+		b.offsets[b.taps] = (i * w0 + (i + 1) * w1) / (w0 + w1);
+	}
+
+	int first = b.levels == 0 ? 0 : 1;
+	b.fbo.assign(b.levels + 1, 0);
+	b.tex.assign(b.levels + 1, 0);
+	glActiveTexture(GL_TEXTURE4);
+	for (int i = first; i <= b.levels; i++) {
+		makeBlurTarget(&b.fbo[i], &b.tex[i], glm::max(width >> i, 1), glm::max(height >> i, 1));
+	}
+	makeBlurTarget(&b.scratchFbo, &b.scratchTex, glm::max(width >> b.levels, 1), glm::max(height >> b.levels, 1));
+
+	b.output = b.tex[first];
+	b.outWidth = glm::max(width >> first, 1);
+	b.outHeight = glm::max(height >> first, 1);
+
+	if (!b.resampleprogram) {
+		b.resampleprogram = loadProgram("shaders/frame.vsh", "shaders/resample.fsh");
+		b.r_src = glGetUniformLocation(b.resampleprogram, "src");
+
+		b.gaussprogram = loadProgram("shaders/frame.vsh", "shaders/gauss.fsh");
+		b.g_src = glGetUniformLocation(b.gaussprogram, "src");
+		b.g_direction = glGetUniformLocation(b.gaussprogram, "direction");
+		b.g_taps = glGetUniformLocation(b.gaussprogram, "taps");
+		b.g_weights = glGetUniformLocation(b.gaussprogram, "weights");
+		b.g_offsets = glGetUniformLocation(b.gaussprogram, "offsets");
+	}
+	if (!b.computeprogram && glExtras.compute) {
+		b.computeprogram = loadComputeProgram("shaders/gauss.csh");
+		b.k_src = glGetUniformLocation(b.computeprogram, "src");
+		b.k_radius = glGetUniformLocation(b.computeprogram, "radius");
+		b.k_kernel = glGetUniformLocation(b.computeprogram, "kernel");
+	}
+
+	glUseProgram(b.resampleprogram);
+	glUniform1i(b.r_src, 4);
+	glUseProgram(b.gaussprogram);
+	glUniform1i(b.g_src, 4);
+	glUniform1i(b.g_taps, b.taps);
+	glUniform1fv(b.g_weights, b.taps + 1, b.weights);
+	glUniform1fv(b.g_offsets, b.taps + 1, b.offsets);
+	if (b.computeprogram) {
+		glUseProgram(b.computeprogram);
+		glUniform1i(b.k_src, 4);
+		glUniform1i(b.k_radius, b.support);
+		glUniform1fv(b.k_kernel, b.support + 1, b.kernel);
+	}
+}
+
+bool blurPyramidCompute(const BlurPyramid & b) {
+	return b.compute && b.computeprogram;
+}
+
+void runBlurPyramid(BlurPyramid & b, GLuint source, GLuint screenVAO) {
+	/*
+	Blurs source (width x height) into b.output
+	Expects depth testing to be disabled; leaves texture unit 4 active and the viewport at full size
+	*/
+	bindVertexArray(screenVAO);
+
+	// downsample; the compute pass cannot read and write the smallest level, so it reads the scratch target
+	bool compute = blurPyramidCompute(b);
+	useProgram(b.resampleprogram);
+	GLuint src = source;
+	for (int i = 1; i <= b.levels; i++) {
+		bool scratch = compute && i == b.levels;
+		bindFramebuffer(scratch ? b.scratchFbo : b.fbo[i]);
+		setViewport(0, 0, glm::max(b.width >> i, 1), glm::max(b.height >> i, 1));
+		bindTexture(4, GL_TEXTURE_2D, src);
+		glDrawArrays(GL_TRIANGLE_STRIP, 0, 4);
+		src = scratch ? b.scratchTex : b.tex[i];
+	}
+
+	// separable gaussian at the smallest level
+	GLsizei w = glm::max(b.width >> b.levels, 1), h = glm::max(b.height >> b.levels, 1);
+	if (compute) {
+		useProgram(b.computeprogram);
+		bindTexture(4, GL_TEXTURE_2D, src);
+		glBindImageTexture(0, b.tex[b.levels], 0, GL_FALSE, 0, GL_WRITE_ONLY, GL_RGBA8);
+		glDispatchCompute((w + BLUR_COMPUTE_TILE - 1) / BLUR_COMPUTE_TILE, (h + BLUR_COMPUTE_TILE - 1) / BLUR_COMPUTE_TILE, 1);
+		glMemoryBarrier(GL_TEXTURE_FETCH_BARRIER_BIT | GL_FRAMEBUFFER_BARRIER_BIT);
+	}
+	else {
+		setViewport(0, 0, w, h);
+		useProgram(b.gaussprogram);
+
+		bindFramebuffer(b.scratchFbo);
+		bindTexture(4, GL_TEXTURE_2D, src);
+		glUniform2f(b.g_direction, 1.f / w, 0.f);
+		glDrawArrays(GL_TRIANGLE_STRIP, 0, 4);
+
+		bindFramebuffer(b.fbo[b.levels]);
+		bindTexture(4, GL_TEXTURE_2D, b.scratchTex);
+		glUniform2f(b.g_direction, 0.f, 1.f / h);
+		glDrawArrays(GL_TRIANGLE_STRIP, 0, 4);
+	}
+
+	// upsample back to level 1; the last step to full resolution is left to the bilinear fetch of the reader
+	useProgram(b.resampleprogram);
+	for (int i = b.levels - 1; i >= 1; i--) {
+		bindFramebuffer(b.fbo[i]);
+		setViewport(0, 0, glm::max(b.width >> i, 1), glm::max(b.height >> i, 1));
+		bindTexture(4, GL_TEXTURE_2D, b.tex[i + 1]);
+		glDrawArrays(GL_TRIANGLE_STRIP, 0, 4);
+	}
+
+	setViewport(0, 0, b.width, b.height);
+}
+
+GLfloat blurPyramidFetches(const BlurPyramid & b) {
+	/*
+	Texture fetches per full-resolution pixel spent by runBlurPyramid (the legacy blur costs 9 * BLUR_PASSES)
+	*/
+	GLfloat fetches = 0.f;
+	for (int i = 1; i <= b.levels; i++) {
+		fetches += 1.f / GLfloat(1 << (2 * i));			// downsample into level i
+		if (i < b.levels) fetches += 1.f / GLfloat(1 << (2 * i));	// upsample into level i
+	}
+	if (blurPyramidCompute(b)) {
+		GLfloat span = GLfloat(BLUR_COMPUTE_TILE + 2 * b.support);	// tile plus apron, read once per work group
+		fetches += span * span / (BLUR_COMPUTE_TILE * BLUR_COMPUTE_TILE) / GLfloat(1 << (2 * b.levels));
+	}
+	else {
+		fetches += 2.f * (2 * b.taps + 1) / GLfloat(1 << (2 * b.levels));
+	}
+	return fetches;
+}
+
+BlurError measureBlurError(const BlurPyramid & b, GLuint reference) {
+	/*
+	Compares b.output, magnified to full resolution the same way the combine pass samples it, against a
+	full-resolution reference texture (the legacy blur). Reads back through the CPU, so only call on demand
+	*/
+	GLuint fbo, tex;
+	makeBlurTarget(&fbo, &tex, b.width, b.height);
+
+	GLuint readFbo;
+	glGenFramebuffers(1, &readFbo);
+	glBindFramebuffer(GL_READ_FRAMEBUFFER, readFbo);
+	glFramebufferTexture2D(GL_READ_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, b.output, 0);
+	glBindFramebuffer(GL_DRAW_FRAMEBUFFER, fbo);
+	glBlitFramebuffer(0, 0, b.outWidth, b.outHeight, 0, 0, b.width, b.height, GL_COLOR_BUFFER_BIT, GL_LINEAR);
+
+	std::vector<unsigned char> a(b.width * b.height * 4), r(b.width * b.height * 4);
+	glPixelStorei(GL_PACK_ALIGNMENT, 1);
+	glBindTexture(GL_TEXTURE_2D, tex);
+	glGetTexImage(GL_TEXTURE_2D, 0, GL_RGBA, GL_UNSIGNED_BYTE, a.data());
+	glBindTexture(GL_TEXTURE_2D, reference);
+	glGetTexImage(GL_TEXTURE_2D, 0, GL_RGBA, GL_UNSIGNED_BYTE, r.data());
+
+	BlurError e = { 0.f, 0.f };
+	double total = 0.0;
+	size_t count = 0;
+	for (size_t i = 0; i < a.size(); i++) {
+		if (i % 4 == 3) continue; // alpha is always 1
+		GLfloat d = fabs(GLfloat(a[i]) - GLfloat(r[i]));
+		total += d;
+		e.max = glm::max(e.max, d);
+		count++;
+	}
+	e.mean = GLfloat(total / count);
+
+	glBindFramebuffer(GL_FRAMEBUFFER, 0);
+	glDeleteFramebuffers(1, &readFbo);
+	glDeleteFramebuffers(1, &fbo);
+	glDeleteTextures(1, &tex);
+	invalidateGLState();
+	return e;
+}
@@ -0,0 +1,60 @@
+#include <caustics.h>
+#include <glstate.h>
+#include <log.h>
+
+void releaseCaustics(Caustics & c) {
+	if (c.fbo) glDeleteFramebuffers(1, &c.fbo);
+	if (c.texture) glDeleteTextures(1, &c.texture);
+	c.fbo = c.texture = 0;
+}
+
+void setupCaustics(Caustics & c, GLsizei size, glm::vec4 rect, GLfloat floor) {
+	releaseCaustics(c);
+	c.size = glm::clamp(size, 1, CAUSTICS_SIZE_MAX);
+	c.rect = rect;
+	c.floor = floor;
+
+	glGenFramebuffers(1, &c.fbo);
+	glGenTextures(1, &c.texture);
+	glBindFramebuffer(GL_FRAMEBUFFER, c.fbo);
+	glActiveTexture(GL_TEXTURE0 + CAUSTICS_UNIT);
+	glBindTexture(GL_TEXTURE_2D, c.texture);
+	// half floats blend on every GL 3.3 context and hold the focused peaks
+	glTexImage2D(GL_TEXTURE_2D, 0, GL_R16F, c.size, c.size, 0, GL_RED, GL_FLOAT, 0);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+	// the walls read the floor's edge
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+	glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, c.texture, 0);
+
+	auto status = glCheckFramebufferStatus(GL_FRAMEBUFFER);
+	if (status != GL_FRAMEBUFFER_COMPLETE) {
+		logMessage(LOG_ERROR, "Cannot setup caustics framebuffer (incomplete): %u.", status);
+	}
+	// still water until the first run
+	glClearColor(1.f, 1.f, 1.f, 1.f);
+	glClear(GL_COLOR_BUFFER_BIT);
+	invalidateGLState();
+}
+
+void runCaustics(Caustics & c, GLuint gridVAO) {
+	/*
+	One instanced strip per row of the grid like the bufferless water. Folded triangles turn over, so
+	nothing is culled, and every triangle adds its light
+	*/
+	bindFramebuffer(c.fbo);
+	setViewport(0, 0, c.size, c.size);
+	glClearColor(0.f, 0.f, 0.f, 0.f);
+	glClear(GL_COLOR_BUFFER_BIT);
+
+	setCapability(GL_DEPTH_TEST, false);
+	setCapability(GL_CULL_FACE, false);
+	setCapability(GL_BLEND, true);
+	glBlendFunc(GL_ONE, GL_ONE);
+	bindVertexArray(gridVAO);
+	glDrawArraysInstanced(GL_TRIANGLE_STRIP, 0, 2 * (c.grid + 1), c.grid);
+	setCapability(GL_BLEND, false);
+
+	bindTexture(CAUSTICS_UNIT, GL_TEXTURE_2D, c.texture);
+}
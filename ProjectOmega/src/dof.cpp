@@ -0,0 +1,284 @@
+#include <dof.h>
+#include <glextra.h>
+#include <glstate.h>
+#include <log.h>
+#include <shaders.h>
+#include <uniforms.h>
+#include <glm/glm.hpp>
+#include <cmath>
+
+static void makeTarget(GLuint * fbo, GLuint * tex, GLenum internalFormat, GLenum format, GLsizei w, GLsizei h, GLint filter) {
+	glGenFramebuffers(1, fbo);
+	glGenTextures(1, tex);
+	glBindFramebuffer(GL_FRAMEBUFFER, *fbo);
+	glBindTexture(GL_TEXTURE_2D, *tex);
+	glTexImage2D(GL_TEXTURE_2D, 0, internalFormat, w, h, 0, format, GL_FLOAT, 0);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, filter);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, filter);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+	glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, *tex, 0);
+
+	auto status = glCheckFramebufferStatus(GL_FRAMEBUFFER);
+	if (status != GL_FRAMEBUFFER_COMPLETE) {
+		logMessage(LOG_ERROR, "Cannot setup depth of field framebuffer (incomplete): %u.", status);
+	}
+}
+
+void releaseDepthOfField(DepthOfField & d) {
+	GLuint fbos[] = { d.cocFbo, d.tileFbo[0], d.tileFbo[1], d.halfFbo, d.fbo };
+	GLuint texs[] = { d.cocTex, d.tileTex[0], d.tileTex[1], d.halfTex, d.output };
+	for (int i = 0; i < 5; i++) {
+		if (fbos[i]) glDeleteFramebuffers(1, &fbos[i]);
+		if (texs[i]) glDeleteTextures(1, &texs[i]);
+	}
+	d.cocFbo = d.tileFbo[0] = d.tileFbo[1] = d.halfFbo = d.fbo = 0;
+	d.cocTex = d.tileTex[0] = d.tileTex[1] = d.halfTex = d.output = 0;
+}
+
+void setupDepthOfField(DepthOfField & d, GLsizei width, GLsizei height, GLfloat fovy) {
+	/*
+	(Re)allocates the targets and derives the lens: the focal length that gives a DOF_SENSOR_HEIGHT frame
+	the field of view fovy, and the scale from the thin-lens CoC diameter A * f / (focus - f) * |d - focus| / d
+	(A = f / fNumber) on the sensor to a radius in pixels of a height-pixel image
+	*/
+	releaseDepthOfField(d);
+	d.width = width;
+	d.height = height;
+	d.tilesX = (width + DOF_TILE - 1) / DOF_TILE;
+	d.tilesY = (height + DOF_TILE - 1) / DOF_TILE;
+	d.halfWidth = glm::max(width / 2, 1);
+	d.halfHeight = glm::max(height / 2, 1);
+
+	d.focalLength = DOF_SENSOR_HEIGHT / (2.f * tan(glm::radians(fovy) / 2.f));
+	d.lensScale = 0.5f * (d.focalLength / d.fNumber) * d.focalLength / DOF_SENSOR_HEIGHT * height;
+
+	glActiveTexture(GL_TEXTURE0 + DOF_COC_UNIT);
+	makeTarget(&d.cocFbo, &d.cocTex, GL_RGBA8, GL_RGBA, width, height, GL_LINEAR);
+	glActiveTexture(GL_TEXTURE0 + DOF_TILE_UNIT);
+	for (int i = 0; i < 2; i++) {
+		makeTarget(&d.tileFbo[i], &d.tileTex[i], GL_R16F, GL_RED, d.tilesX, d.tilesY, GL_NEAREST);
+	}
+	glActiveTexture(GL_TEXTURE4);
+	makeTarget(&d.halfFbo, &d.halfTex, GL_RGBA8, GL_RGBA, d.halfWidth, d.halfHeight, GL_LINEAR);
+	makeTarget(&d.fbo, &d.output, GL_RGBA8, GL_RGBA, width, height, GL_LINEAR);
+
+	if (!d.cocprogram) {
+		d.cocprogram = loadProgram("shaders/frame.vsh", "shaders/dofcoc.fsh");
+		d.c_color = glGetUniformLocation(d.cocprogram, "color");
+		d.c_depth = glGetUniformLocation(d.cocprogram, "depth");
+		d.c_lens = glGetUniformLocation(d.cocprogram, "lens");
+		d.c_focus = glGetUniformLocation(d.cocprogram, "focusTex");
+		d.c_autofocus = glGetUniformLocation(d.cocprogram, "autofocus");
+		bindUniformBlocks(d.cocprogram);
+
+		d.tileprogram = loadProgram("shaders/frame.vsh", "shaders/doftile.fsh");
+		d.t_coc = glGetUniformLocation(d.tileprogram, "coc");
+
+		d.dilateprogram = loadProgram("shaders/frame.vsh", "shaders/dofdilate.fsh");
+		d.d_tiles = glGetUniformLocation(d.dilateprogram, "tiles");
+
+		d.gatherprogram = loadProgram("shaders/frame.vsh", "shaders/dofgather.fsh");
+		d.g_coc = glGetUniformLocation(d.gatherprogram, "coc");
+		d.g_tiles = glGetUniformLocation(d.gatherprogram, "tiles");
+		d.g_taps = glGetUniformLocation(d.gatherprogram, "taps");
+
+		d.compositeprogram = loadProgram("shaders/frame.vsh", "shaders/dofcomposite.fsh");
+		d.m_coc = glGetUniformLocation(d.compositeprogram, "coc");
+		d.m_tiles = glGetUniformLocation(d.compositeprogram, "tiles");
+		d.m_gathered = glGetUniformLocation(d.compositeprogram, "gathered");
+
+		d.blendprogram = loadProgram("shaders/frame.vsh", "shaders/dofblend.fsh");
+		d.b_coc = glGetUniformLocation(d.blendprogram, "coc");
+		d.b_tiles = glGetUniformLocation(d.blendprogram, "tiles");
+		d.b_blurred = glGetUniformLocation(d.blendprogram, "blurred");
+	}
+	if (!d.gathercompute && glExtras.compute) {
+		d.gathercompute = loadComputeProgram("shaders/dofgather.csh");
+		d.k_coc = glGetUniformLocation(d.gathercompute, "coc");
+		d.k_tiles = glGetUniformLocation(d.gathercompute, "tiles");
+		d.k_taps = glGetUniformLocation(d.gathercompute, "taps");
+	}
+
+	glUseProgram(d.cocprogram);
+	glUniform1i(d.c_color, 3);
+	glUniform1i(d.c_depth, 5);
+	glUniform2f(d.c_lens, d.lensScale, d.focalLength);
+	glUniform1i(d.c_focus, DOF_FOCUS_UNIT);
+	glUseProgram(d.tileprogram);
+	glUniform1i(d.t_coc, DOF_COC_UNIT);
+	glUseProgram(d.dilateprogram);
+	glUniform1i(d.d_tiles, DOF_TILE_UNIT);
+	glUseProgram(d.gatherprogram);
+	glUniform1i(d.g_coc, DOF_COC_UNIT);
+	glUniform1i(d.g_tiles, DOF_TILE_UNIT);
+	glUniform1i(d.g_taps, DOF_TAPS);
+	glUseProgram(d.compositeprogram);
+	glUniform1i(d.m_coc, DOF_COC_UNIT);
+	glUniform1i(d.m_tiles, DOF_TILE_UNIT);
+	glUniform1i(d.m_gathered, 4);
+	glUseProgram(d.blendprogram);
+	glUniform1i(d.b_coc, DOF_COC_UNIT);
+	glUniform1i(d.b_tiles, DOF_TILE_UNIT);
+	glUniform1i(d.b_blurred, 4);
+	if (d.gathercompute) {
+		glUseProgram(d.gathercompute);
+		glUniform1i(d.k_coc, DOF_COC_UNIT);
+		glUniform1i(d.k_tiles, DOF_TILE_UNIT);
+		glUniform1i(d.k_taps, DOF_TAPS);
+	}
+}
+
+void runDepthOfField(DepthOfField & d, GLuint color, GLuint depth, GLuint blurred, GLuint focus, GLuint screenVAO) {
+	bindVertexArray(screenVAO);
+
+	// color + signed CoC
+	bindFramebuffer(d.cocFbo);
+	setViewport(0, 0, d.width, d.height);
+	bindTexture(3, GL_TEXTURE_2D, color);
+	bindTexture(5, GL_TEXTURE_2D, depth);
+	if (focus) {
+		bindTexture(DOF_FOCUS_UNIT, GL_TEXTURE_2D, focus);
+	}
+	useProgram(d.cocprogram);
+	glUniform1i(d.c_autofocus, focus != 0);
+	glDrawArrays(GL_TRIANGLE_STRIP, 0, 4);
+
+	// largest CoC per tile, then per 3x3 tiles
+	setViewport(0, 0, d.tilesX, d.tilesY);
+	bindTexture(DOF_COC_UNIT, GL_TEXTURE_2D, d.cocTex);
+	bindFramebuffer(d.tileFbo[0]);
+	useProgram(d.tileprogram);
+	glDrawArrays(GL_TRIANGLE_STRIP, 0, 4);
+
+	bindTexture(DOF_TILE_UNIT, GL_TEXTURE_2D, d.tileTex[0]);
+	bindFramebuffer(d.tileFbo[1]);
+	useProgram(d.dilateprogram);
+	glDrawArrays(GL_TRIANGLE_STRIP, 0, 4);
+
+	bindTexture(DOF_TILE_UNIT, GL_TEXTURE_2D, d.tileTex[1]);
+	if (!blurred && d.compute && d.gathercompute) {
+		useProgram(d.gathercompute);
+		glBindImageTexture(0, d.halfTex, 0, GL_FALSE, 0, GL_WRITE_ONLY, GL_RGBA8);
+		glDispatchCompute((d.halfWidth + DOF_COMPUTE_GROUP - 1) / DOF_COMPUTE_GROUP, (d.halfHeight + DOF_COMPUTE_GROUP - 1) / DOF_COMPUTE_GROUP, 1);
+		glMemoryBarrier(GL_TEXTURE_FETCH_BARRIER_BIT);
+	}
+	else if (!blurred) {
+		bindFramebuffer(d.halfFbo);
+		setViewport(0, 0, d.halfWidth, d.halfHeight);
+		useProgram(d.gatherprogram);
+		glDrawArrays(GL_TRIANGLE_STRIP, 0, 4);
+	}
+
+	// sharp tiles copy, the others mix in the gathered or the blurred image
+	bindFramebuffer(d.fbo);
+	setViewport(0, 0, d.width, d.height);
+	bindTexture(4, GL_TEXTURE_2D, blurred ? blurred : d.halfTex);
+	useProgram(blurred ? d.blendprogram : d.compositeprogram);
+	glDrawArrays(GL_TRIANGLE_STRIP, 0, 4);
+}
+
+GLfloat dofSharpTiles(const DepthOfField & d) {
+	std::vector<GLfloat> radius(d.tilesX * d.tilesY);
+	glPixelStorei(GL_PACK_ALIGNMENT, 1);
+	bindTexture(DOF_TILE_UNIT, GL_TEXTURE_2D, d.tileTex[1]);
+	activeTexture(DOF_TILE_UNIT);
+	glGetTexImage(GL_TEXTURE_2D, 0, GL_RED, GL_FLOAT, radius.data());
+
+	size_t sharp = 0;
+	for (GLfloat r : radius) {
+		sharp += r < 0.5f;
+	}
+	return radius.empty() ? 0.f : GLfloat(sharp) / radius.size();
+}
+
+void setupAutofocus(Autofocus & a) {
+	GLfloat zero = 0.f;
+	glActiveTexture(GL_TEXTURE0 + DOF_FOCUS_UNIT);
+	makeTarget(&a.sampleFbo, &a.sampleTex, GL_R32F, GL_RED, AUTOFOCUS_SAMPLES, AUTOFOCUS_SAMPLES, GL_NEAREST);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST_MIPMAP_NEAREST);
+	glGenerateMipmap(GL_TEXTURE_2D);
+	for (int i = 0; i < 2; i++) {
+		makeTarget(&a.fbo[i], &a.tex[i], GL_R32F, GL_RED, 1, 1, GL_NEAREST);
+		glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, 1, 1, GL_RED, GL_FLOAT, &zero);
+	}
+	a.current = 0;
+	a.output = a.tex[0];
+
+	glGenBuffers(AUTOFOCUS_READBACK, a.pbo);
+	for (int i = 0; i < AUTOFOCUS_READBACK; i++) {
+		glBindBuffer(GL_PIXEL_PACK_BUFFER, a.pbo[i]);
+		glBufferData(GL_PIXEL_PACK_BUFFER, sizeof(GLfloat), NULL, GL_STREAM_READ);
+		a.fences[i] = 0;
+	}
+	glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+
+	a.sampleprogram = loadProgram("shaders/frame.vsh", "shaders/focussample.fsh");
+	a.s_depth = glGetUniformLocation(a.sampleprogram, "depth");
+	a.s_region = glGetUniformLocation(a.sampleprogram, "region");
+	bindUniformBlocks(a.sampleprogram);
+
+	a.smoothprogram = loadProgram("shaders/frame.vsh", "shaders/focussmooth.fsh");
+	a.m_samples = glGetUniformLocation(a.smoothprogram, "samples");
+	a.m_history = glGetUniformLocation(a.smoothprogram, "history");
+	a.m_rate = glGetUniformLocation(a.smoothprogram, "rate");
+	a.m_level = glGetUniformLocation(a.smoothprogram, "level");
+
+	glUseProgram(a.sampleprogram);
+	glUniform1i(a.s_depth, 5);
+	glUseProgram(a.smoothprogram);
+	glUniform1i(a.m_samples, DOF_FOCUS_UNIT);
+	glUniform1i(a.m_history, DOF_FOCUS_UNIT + 1);
+	glUniform1f(a.m_level, GLfloat(log2(AUTOFOCUS_SAMPLES)));
+}
+
+void runAutofocus(Autofocus & a, GLuint depth, GLfloat time, GLuint screenVAO) {
+	/*
+	Leaves the viewport at 1x1 and the new focus texture bound to DOF_FOCUS_UNIT
+	*/
+	bindVertexArray(screenVAO);
+
+	// inverse distances under the region, averaged by the mip chain
+	bindFramebuffer(a.sampleFbo);
+	setViewport(0, 0, AUTOFOCUS_SAMPLES, AUTOFOCUS_SAMPLES);
+	bindTexture(5, GL_TEXTURE_2D, depth);
+	useProgram(a.sampleprogram);
+	glUniform4fv(a.s_region, 1, a.region);
+	glDrawArrays(GL_TRIANGLE_STRIP, 0, 4);
+	bindTexture(DOF_FOCUS_UNIT, GL_TEXTURE_2D, a.sampleTex);
+	activeTexture(DOF_FOCUS_UNIT);
+	glGenerateMipmap(GL_TEXTURE_2D);
+
+	// ease towards it, frame rate independent
+	GLfloat rate = a.lastTime < 0.f ? 1.f : 1.f - exp(-glm::max(time - a.lastTime, 0.f) / AUTOFOCUS_TIME);
+	a.lastTime = time;
+	bindTexture(DOF_FOCUS_UNIT + 1, GL_TEXTURE_2D, a.tex[a.current]);
+	a.current ^= 1;
+	bindFramebuffer(a.fbo[a.current]);
+	setViewport(0, 0, 1, 1);
+	useProgram(a.smoothprogram);
+	glUniform1f(a.m_rate, rate);
+	glDrawArrays(GL_TRIANGLE_STRIP, 0, 4);
+	a.output = a.tex[a.current];
+	bindTexture(DOF_FOCUS_UNIT, GL_TEXTURE_2D, a.output);
+
+	if (a.readback) {
+		// the oldest buffer in the ring is read only if the GPU has passed its fence, never waited for
+		GLsync & fence = a.fences[a.next];
+		glBindBuffer(GL_PIXEL_PACK_BUFFER, a.pbo[a.next]);
+		if (fence) {
+			if (glClientWaitSync(fence, 0, 0) == GL_TIMEOUT_EXPIRED) {
+				a.misses++;
+			}
+			else {
+				glGetBufferSubData(GL_PIXEL_PACK_BUFFER, 0, sizeof(GLfloat), &a.focus);
+				a.reads++;
+			}
+			glDeleteSync(fence);
+		}
+		glReadPixels(0, 0, 1, 1, GL_RED, GL_FLOAT, 0);
+		fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+		glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+		a.next = (a.next + 1) % AUTOFOCUS_READBACK;
+	}
+}
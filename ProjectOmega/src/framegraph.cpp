@@ -0,0 +1,270 @@
+#include <framegraph.h>
+#include <glstate.h>
+#include <log.h>
+#include <algorithm>
+
+static void formatOf(GLenum internalFormat, GLenum & format, GLenum & type, GLsizei & bytes) {
+	switch (internalFormat) {
+	case GL_DEPTH_COMPONENT24: format = GL_DEPTH_COMPONENT; type = GL_UNSIGNED_INT; bytes = 4; break;
+	case GL_R16F: format = GL_RED; type = GL_FLOAT; bytes = 2; break;
+	case GL_R32F: format = GL_RED; type = GL_FLOAT; bytes = 4; break;
+	case GL_RGBA16F: format = GL_RGBA; type = GL_FLOAT; bytes = 8; break;
+	default: format = GL_RGBA; type = GL_UNSIGNED_BYTE; bytes = 4; break;
+	}
+}
+
+static size_t sizeOf(const FrameTextureDesc & d) {
+	GLenum format, type;
+	GLsizei bytes;
+	formatOf(d.internalFormat, format, type, bytes);
+	return size_t(d.width) * d.height * bytes;
+}
+
+void resetFrameGraph(FrameGraph & g) {
+	g.resources.clear();
+	g.passes.clear();
+}
+
+void releaseFrameGraph(FrameGraph & g) {
+	resetFrameGraph(g);
+	for (auto & entry : g.fbos) {
+		glDeleteFramebuffers(1, &entry.second);
+	}
+	g.fbos.clear();
+	for (FramePoolTexture & t : g.pool) {
+		glDeleteTextures(1, &t.texture);
+	}
+	g.pool.clear();
+	g.bytes = g.unaliasedBytes = 0;
+	invalidateGLState();
+}
+
+int addFrameTexture(FrameGraph & g, const std::string & name, const FrameTextureDesc & desc) {
+	FrameResource r;
+	r.name = name;
+	r.desc = desc;
+	g.resources.push_back(r);
+	return int(g.resources.size()) - 1;
+}
+
+int importFrameTexture(FrameGraph & g, const std::string & name, GLuint texture) {
+	FrameResource r;
+	r.name = name;
+	r.imported = true;
+	r.texture = texture;
+	g.resources.push_back(r);
+	return int(g.resources.size()) - 1;
+}
+
+int importFramebuffer(FrameGraph & g, const std::string & name, GLuint fbo, GLsizei width, GLsizei height) {
+	FrameResource r;
+	r.name = name;
+	r.imported = true;
+	r.output = true;
+	r.fbo = fbo;
+	r.desc.width = width;
+	r.desc.height = height;
+	g.resources.push_back(r);
+	return int(g.resources.size()) - 1;
+}
+
+FramePass & addFramePass(FrameGraph & g, const std::string & name, const std::vector<int> & reads, const std::vector<int> & writes, std::function<void()> execute) {
+	FramePass p;
+	p.name = name;
+	p.reads = reads;
+	p.writes = writes;
+	p.execute = execute;
+	g.passes.push_back(p);
+	return g.passes.back();
+}
+
+GLuint frameTexture(const FrameGraph & g, int resource) {
+	return g.resources[resource].texture;
+}
+
+GLuint frameFramebuffer(FrameGraph & g, int color, int depth) {
+	GLuint colorTex = color >= 0 ? g.resources[color].texture : 0, depthTex = depth >= 0 ? g.resources[depth].texture : 0;
+	GLuint & fbo = g.fbos[std::make_pair(colorTex, depthTex)];
+	if (!fbo) {
+		glGenFramebuffers(1, &fbo);
+		bindFramebuffer(fbo);
+		glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, colorTex, 0);
+		if (!colorTex) {
+			glDrawBuffer(GL_NONE);
+			glReadBuffer(GL_NONE);
+		}
+		glFramebufferTexture2D(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_TEXTURE_2D, depthTex, 0);
+	}
+	return fbo;
+}
+
+static bool writesImport(const FrameGraph & g, const FramePass & p) {
+	for (int w : p.writes) {
+		if (g.resources[w].output) {
+			return true;
+		}
+	}
+	return false;
+}
+
+bool compileFrameGraph(FrameGraph & g) {
+	/*
+	Culls, schedules the transient textures onto the pool and makes the pass framebuffers
+	*/
+	for (FramePass & p : g.passes) {
+		if (p.color >= 0 && std::find(p.writes.begin(), p.writes.end(), p.color) == p.writes.end()) p.writes.push_back(p.color);
+		if (p.depth >= 0 && std::find(p.writes.begin(), p.writes.end(), p.depth) == p.writes.end()) p.writes.push_back(p.depth);
+	}
+
+	// cull back to front: a pass is needed if it must run anyway or a needed later pass reads what it writes
+	std::vector<bool> needed(g.resources.size(), false);
+	g.culled = 0;
+	for (int i = int(g.passes.size()) - 1; i >= 0; i--) {
+		FramePass & p = g.passes[i];
+		p.culled = !p.sideEffect && !writesImport(g, p);
+		for (int w : p.writes) {
+			if (needed[w]) p.culled = false;
+		}
+		if (p.culled) {
+			g.culled++;
+			continue;
+		}
+		for (int r : p.reads) {
+			needed[r] = true;
+		}
+	}
+
+	// lifetimes over the passes that run
+	for (FrameResource & r : g.resources) {
+		r.first = r.last = -1;
+		r.slot = -1;
+	}
+	for (int i = 0; i < int(g.passes.size()); i++) {
+		const FramePass & p = g.passes[i];
+		if (p.culled) continue;
+		for (const std::vector<int> * list : { &p.reads, &p.writes }) {
+			for (int id : *list) {
+				FrameResource & r = g.resources[id];
+				if (r.first < 0) r.first = i;
+				r.last = i;
+			}
+		}
+		for (int id : p.reads) {
+			const FrameResource & r = g.resources[id];
+			if (!r.imported && r.first == i && std::find(p.writes.begin(), p.writes.end(), id) == p.writes.end()) {
+				logMessage(LOG_WARN, "Frame graph: %s reads %s before any pass writes it", p.name.c_str(), r.name.c_str());
+			}
+		}
+	}
+
+	// in order of first use, each transient takes the first pool texture of its description that is free by then
+	for (FramePoolTexture & t : g.pool) {
+		t.busyUntil = -1;
+	}
+	std::vector<bool> used(g.pool.size(), false);
+	g.unaliasedBytes = 0;
+	for (int i = 0; i < int(g.passes.size()); i++) {
+		for (FrameResource & r : g.resources) {
+			if (r.imported || r.first != i) continue;
+			g.unaliasedBytes += sizeOf(r.desc);
+			for (size_t t = 0; t < g.pool.size() && r.slot < 0; t++) {
+				if (g.pool[t].desc == r.desc && g.pool[t].busyUntil < r.first) {
+					r.slot = int(t);
+				}
+			}
+			if (r.slot < 0) {
+				FramePoolTexture t;
+				t.desc = r.desc;
+				GLenum format, type;
+				GLsizei bytes;
+				formatOf(r.desc.internalFormat, format, type, bytes);
+				glGenTextures(1, &t.texture);
+				glBindTexture(GL_TEXTURE_2D, t.texture);
+				glTexImage2D(GL_TEXTURE_2D, 0, r.desc.internalFormat, r.desc.width, r.desc.height, 0, format, type, 0);
+				glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, r.desc.filter);
+				glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, r.desc.filter);
+				glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+				glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+				g.pool.push_back(t);
+				used.push_back(false);
+				r.slot = int(g.pool.size()) - 1;
+			}
+			g.pool[r.slot].busyUntil = r.last;
+			used[r.slot] = true;
+			r.texture = g.pool[r.slot].texture;
+		}
+	}
+
+	// textures no longer scheduled go back to the driver, with every framebuffer that used them
+	std::vector<FramePoolTexture> kept;
+	std::map<GLuint, bool> alive;
+	g.bytes = 0;
+	for (size_t t = 0; t < g.pool.size(); t++) {
+		if (used[t]) {
+			alive[g.pool[t].texture] = true;
+			g.bytes += sizeOf(g.pool[t].desc);
+			kept.push_back(g.pool[t]);
+		}
+		else {
+			glDeleteTextures(1, &g.pool[t].texture);
+		}
+	}
+	for (FrameResource & r : g.resources) {
+		if (r.imported) continue;
+		for (size_t t = 0; t < kept.size(); t++) {
+			if (kept[t].texture == r.texture) r.slot = int(t);
+		}
+	}
+	g.pool = kept;
+	for (auto it = g.fbos.begin(); it != g.fbos.end();) {
+		bool stale = (it->first.first && !alive.count(it->first.first)) || (it->first.second && !alive.count(it->first.second));
+		if (stale) {
+			glDeleteFramebuffers(1, &it->second);
+			it = g.fbos.erase(it);
+		}
+		else {
+			++it;
+		}
+	}
+	invalidateGLState();
+
+	// targets the graph binds
+	bool complete = true;
+	for (FramePass & p : g.passes) {
+		p.fbo = 0;
+		if (p.culled || (p.color < 0 && p.depth < 0)) continue;
+		const FrameResource & target = g.resources[p.color >= 0 ? p.color : p.depth];
+		p.width = target.desc.width;
+		p.height = target.desc.height;
+		if (target.imported) {
+			p.fbo = target.fbo;
+			continue;
+		}
+		p.fbo = frameFramebuffer(g, p.color, p.depth);
+		bindFramebuffer(p.fbo);
+		GLenum status = glCheckFramebufferStatus(GL_FRAMEBUFFER);
+		if (status != GL_FRAMEBUFFER_COMPLETE) {
+			logMessage(LOG_ERROR, "Cannot setup framebuffer of %s (incomplete): %u.", p.name.c_str(), status);
+			complete = false;
+		}
+	}
+	return complete;
+}
+
+void executeFrameGraph(FrameGraph & g, Profiler & prof) {
+	for (FramePass & p : g.passes) {
+		if (p.culled) continue;
+		if (p.profile >= 0) profilerBegin(prof, p.profile);
+		if (p.color >= 0 || p.depth >= 0) {
+			bindFramebuffer(p.fbo);
+			setViewport(0, 0, p.width, p.height);
+			if (p.clear) {
+				setCapability(GL_SCISSOR_TEST, false);
+				glClearColor(p.clearColor.r, p.clearColor.g, p.clearColor.b, p.clearColor.a);
+				glClear(p.clear);
+			}
+		}
+		p.execute();
+		if (p.profile >= 0) profilerEnd(prof, p.profile);
+	}
+}
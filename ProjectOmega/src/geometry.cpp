@@ -0,0 +1,453 @@
+#include <geometry.h>
+#include <assert.h>
+#include <algorithm>
+#include <cmath>
+
+std::vector<Vertex> genPlane(glm::vec3 u, glm::vec3 v, const glm::vec3& start, const GLuint resolution) {
+	/*
+	Generates a plane
+	u -> one side of the plane
+	v -> the other side of the plane
+	Size of the plane depends on the magnitude of u and v
+	start -> lower left corner of the plane
+	resolution -> how many points are in the plane (resolution of 1 generates 4 points, resolution of 2 generates 9 vertices, 3 -> 12, etc
+	*/
+	u /= resolution; v /= resolution;
+	std::vector<Vertex> mesh;
+	glm::vec3 normal = glm::normalize(glm::cross(u, v));
+
+	for (GLuint row = 0; row < resolution; ++row) {
+		if (row != 0) {
+			glm::vec3 p = v * (row + 1.f) + start;
+			mesh.push_back(Vertex{ p.x, p.y, p.z, normal.x, normal.y, normal.z });
+		}
+		for (GLuint col = 0; col < resolution; ++col) {
+			glm::vec3 p = u * float(col) + v * (row + 1.f) + start;
+			mesh.push_back(Vertex{ p.x, p.y, p.z, normal.x, normal.y, normal.z });
+
+			glm::vec3 p1 = u * float(col) + v * float(row) + start;
+			mesh.push_back(Vertex{ p1.x, p1.y, p1.z, normal.x, normal.y, normal.z });
+		}
+		glm::vec3 p = u * float(resolution) + v * (row + 1.f) + start;
+		mesh.push_back(Vertex{ p.x, p.y, p.z, normal.x, normal.y, normal.z });
+		glm::vec3 p1 = u * float(resolution) + v * float(row) + start;
+		mesh.push_back(Vertex{ p1.x, p1.y, p1.z, normal.x, normal.y, normal.z });
+
+		if (row + 1 != resolution) {
+			mesh.push_back(mesh.back());
+		}
+	}
+
+	return mesh;
+}
+
+std::vector<Vertex> genCube(const GLfloat size, const unsigned int resolution, const glm::vec3 & offset) {
+	/*
+	Uses genPlane 6 times to make a cube
+	size -> length of a side
+	resolution -> how many points are generated
+	offset -> position upon initialization (center)
+	*/
+	std::vector<Vertex> mesh;
+	glm::vec3 u, v, o;
+	for (GLuint side = 0; side < 6; ++side) {
+		switch (side >> 1) {
+		case 0:
+			o = glm::vec3(size * 0.5, 0, 0);
+			u = glm::vec3(0, 0, -size);
+			v = glm::vec3(0, size, 0);
+			break;
+		case 1:
+			o = glm::vec3(0, size * 0.5, 0);
+			u = glm::vec3(size, 0, 0);
+			v = glm::vec3(0, 0, -size);
+			break;
+		case 2:
+			o = glm::vec3(0, 0, size * 0.5);
+			u = glm::vec3(size, 0, 0);
+			v = glm::vec3(0, size, 0);
+			break;
+		default:
+			assert(false && "Should never happen.");
+		}
+
+		if (side % 2 == 1) {
+			o *= -1;
+			u *= -1;
+		}
+		o -= (u + v) / 2.f;
+
+		const auto & p = genPlane(u, v, o + offset, resolution);
+		if (!mesh.empty()) {
+			mesh.push_back(mesh.back());
+			mesh.push_back(p.front());
+		}
+		mesh.insert(mesh.end(), p.begin(), p.end());
+	}
+
+	return mesh;
+}
+
+std::vector<Vertex> genSphere(GLfloat radius, GLuint resolution, const glm::vec3 & offset) {
+	/*
+	Uses genCube to generate a sphere
+	Offsets the vertices of each cube by radius relative to a center, and is then offset to position (offset)
+	*/
+	auto cube = genCube(1.f, resolution);
+	for (Vertex& v : cube) {
+		glm::vec3 pos(v.x, v.y, v.z);
+		pos = pos * (radius / glm::length(pos)) + offset;
+
+		glm::vec3 nor(0.f);
+		nor = pos / glm::length(pos);
+
+		v.x = pos.x;
+		v.y = pos.y;
+		v.z = pos.z;
+		v.x1 = nor.x;
+		v.y1 = nor.y;
+		v.z1 = nor.z;
+	}
+	return cube;
+}
+
+//================================== with texture ========================================
+
+std::vector<NewVertex> genTexPlane(glm::vec3 u, glm::vec3 v, const glm::vec3 & start, const GLuint resolution) {
+	/*
+	 Generates a plane
+	 u -> one side of the plane
+	 v -> the other side of the plane
+	 Size of the plane depends on the magnitude of u and v
+	 start -> lower left corner of the plane
+	 resolution -> how many points are in the plane (resolution of 1 generates 4 points, resolution of 2 generates 9 vertices, 3 -> 12, etc
+	 */
+	u /= resolution; v /= resolution;
+	std::vector<NewVertex> mesh;
+	glm::vec3 normal = glm::normalize(glm::cross(u, v));
+
+	for (GLuint row = 0; row < resolution; ++row) {
+		if (row != 0) {
+			glm::vec3 p = v * (row + 1.f) + start;
+			mesh.push_back(NewVertex{ p.x, p.y, p.z, normal.x, normal.y, normal.z, 0.f , float(row + 1) / resolution });
+		}
+		for (GLuint col = 0; col < resolution; ++col) {
+			glm::vec3 p = u * float(col) + v * (row + 1.f) + start;
+			mesh.push_back(NewVertex{ p.x, p.y, p.z, normal.x, normal.y, normal.z, float(col) / resolution , float(row + 1) / resolution });
+
+			glm::vec3 p1 = u * float(col) + v * float(row) + start;
+			mesh.push_back(NewVertex{ p1.x, p1.y, p1.z, normal.x, normal.y, normal.z, float(col) / resolution , float(row) / resolution });
+		}
+		glm::vec3 p = u * float(resolution) + v * (row + 1.f) + start;
+		mesh.push_back(NewVertex{ p.x, p.y, p.z, normal.x, normal.y, normal.z, 1.f, float(row + 1) / resolution });
+		glm::vec3 p1 = u * float(resolution) + v * float(row) + start;
+		mesh.push_back(NewVertex{ p1.x, p1.y, p1.z, normal.x, normal.y, normal.z, 1.f , float(row) / resolution });
+
+		if (row + 1 != resolution) {
+			mesh.push_back(mesh.back());
+		}
+	}
+
+	return mesh;
+}
+
+std::vector<NewVertex> genTexCube(const GLfloat size, const unsigned int resolution, const glm::vec3 & offset) {
+	/*
+	 Uses genPlane 6 times to make a cube
+	 size -> length of a side
+	 resolution -> how many points are generated
+	 offset -> position upon initialization (center)
+	 */
+	std::vector<NewVertex> mesh;
+	glm::vec3 u, v, o;
+	for (GLuint side = 0; side < 6; ++side) {
+		switch (side >> 1) {
+		case 0:
+			o = glm::vec3(size * 0.5, 0, 0);
+			u = glm::vec3(0, 0, -size);
+			v = glm::vec3(0, size, 0);
+			break;
+		case 1:
+			o = glm::vec3(0, size * 0.5, 0);
+			u = glm::vec3(size, 0, 0);
+			v = glm::vec3(0, 0, -size);
+			break;
+		case 2:
+			o = glm::vec3(0, 0, size * 0.5);
+			u = glm::vec3(size, 0, 0);
+			v = glm::vec3(0, size, 0);
+			break;
+		default:
+			assert(false && "Should never happen.");
+		}
+
+		if (side % 2 == 1) {
+			o *= -1;
+			u *= -1;
+		}
+		o -= (u + v) / 2.f;
+
+		const auto & p = genTexPlane(u, v, o + offset, resolution);
+		if (!mesh.empty()) {
+			mesh.push_back(mesh.back());
+			mesh.push_back(p.front());
+		}
+		mesh.insert(mesh.end(), p.begin(), p.end());
+	}
+
+	return mesh;
+}
+
+//================================== indexed ========================================
+
+static void setVertex(Vertex & out, const glm::vec3 & p, const glm::vec3 & n, GLfloat, GLfloat) {
+	out = Vertex{ p.x, p.y, p.z, n.x, n.y, n.z };
+}
+
+static void setVertex(NewVertex & out, const glm::vec3 & p, const glm::vec3 & n, GLfloat s, GLfloat t) {
+	out = NewVertex{ p.x, p.y, p.z, n.x, n.y, n.z, s, t };
+}
+
+template <typename V>
+static void appendGrid(IndexedMesh<V> & mesh, glm::vec3 u, glm::vec3 v, const glm::vec3 & start, const GLuint resolution) {
+	/*
+	Appends the grid genPlane / genTexPlane would make, without the strip's duplicated and degenerate vertices
+	Vertex (col, row) sits at start + u * col / resolution + v * row / resolution
+	*/
+	u /= resolution; v /= resolution;
+	glm::vec3 normal = glm::normalize(glm::cross(u, v));
+	GLuint base = mesh.vertices.size(), stride = resolution + 1;
+
+	mesh.vertices.resize(base + stride * stride);
+	for (GLuint row = 0; row <= resolution; ++row) {
+		for (GLuint col = 0; col <= resolution; ++col) {
+			glm::vec3 p = u * float(col) + v * float(row) + start;
+			setVertex(mesh.vertices[base + row * stride + col], p, normal, float(col) / resolution, float(row) / resolution);
+		}
+	}
+
+	// the two triangles the strip makes for each quad: (top left, bottom left, top right), (top right, bottom left, bottom right)
+	for (GLuint row = 0; row < resolution; ++row) {
+		for (GLuint col = 0; col < resolution; ++col) {
+			GLuint b0 = base + row * stride + col, b1 = b0 + 1, t0 = b0 + stride, t1 = t0 + 1;
+			GLuint quad[6] = { t0, b0, t1, t1, b0, b1 };
+			mesh.indices.insert(mesh.indices.end(), quad, quad + 6);
+		}
+	}
+}
+
+template <typename V>
+static void appendCube(IndexedMesh<V> & mesh, const GLfloat size, const unsigned int resolution, const glm::vec3 & offset) {
+	/*
+	The six faces of genCube, each its own grid since the normals differ along the edges
+	*/
+	glm::vec3 u, v, o;
+	for (GLuint side = 0; side < 6; ++side) {
+		switch (side >> 1) {
+		case 0:
+			o = glm::vec3(size * 0.5, 0, 0);
+			u = glm::vec3(0, 0, -size);
+			v = glm::vec3(0, size, 0);
+			break;
+		case 1:
+			o = glm::vec3(0, size * 0.5, 0);
+			u = glm::vec3(size, 0, 0);
+			v = glm::vec3(0, 0, -size);
+			break;
+		case 2:
+			o = glm::vec3(0, 0, size * 0.5);
+			u = glm::vec3(size, 0, 0);
+			v = glm::vec3(0, size, 0);
+			break;
+		default:
+			assert(false && "Should never happen.");
+		}
+
+		if (side % 2 == 1) {
+			o *= -1;
+			u *= -1;
+		}
+		o -= (u + v) / 2.f;
+
+		appendGrid(mesh, u, v, o + offset, resolution);
+	}
+}
+
+IndexedMesh<Vertex> genIndexedPlane(glm::vec3 u, glm::vec3 v, const glm::vec3 & start, const GLuint resolution) {
+	IndexedMesh<Vertex> mesh;
+	appendGrid(mesh, u, v, start, resolution);
+	optimizeVertexCache(mesh.indices, mesh.vertices.size());
+	return mesh;
+}
+
+IndexedMesh<Vertex> genIndexedCube(const GLfloat size, const unsigned int resolution, const glm::vec3 & offset) {
+	IndexedMesh<Vertex> mesh;
+	appendCube(mesh, size, resolution, offset);
+	optimizeVertexCache(mesh.indices, mesh.vertices.size());
+	return mesh;
+}
+
+IndexedMesh<Vertex> genIndexedSphere(GLfloat radius, GLuint resolution, const glm::vec3 & offset) {
+	/*
+	Same projection of a unit cube as genSphere
+	*/
+	IndexedMesh<Vertex> mesh = genIndexedCube(1.f, resolution);
+	for (Vertex & v : mesh.vertices) {
+		glm::vec3 pos(v.x, v.y, v.z);
+		pos = pos * (radius / glm::length(pos)) + offset;
+		glm::vec3 nor = pos / glm::length(pos);
+		v = Vertex{ pos.x, pos.y, pos.z, nor.x, nor.y, nor.z };
+	}
+	return mesh;
+}
+
+IndexedMesh<NewVertex> genIndexedTexPlane(glm::vec3 u, glm::vec3 v, const glm::vec3 & start, const GLuint resolution) {
+	IndexedMesh<NewVertex> mesh;
+	appendGrid(mesh, u, v, start, resolution);
+	optimizeVertexCache(mesh.indices, mesh.vertices.size());
+	return mesh;
+}
+
+IndexedMesh<NewVertex> genIndexedTexCube(const GLfloat size, const unsigned int resolution, const glm::vec3 & offset) {
+	IndexedMesh<NewVertex> mesh;
+	appendCube(mesh, size, resolution, offset);
+	optimizeVertexCache(mesh.indices, mesh.vertices.size());
+	return mesh;
+}
+
+static GLfloat vertexScore(int cachePos, GLuint remaining) {
+	/*
+	Forsyth's scoring: the three most recent vertices get a flat score so the next triangle does not
+	simply reuse the last edge, older entries decay with their age, and vertices with few triangles
+	left are boosted so they get finished and leave the cache
+	*/
+	if (remaining == 0) {
+		return -1.f;
+	}
+	GLfloat score = 0.f;
+	if (cachePos >= 0) {
+		if (cachePos < 3) {
+			score = 0.75f;
+		}
+		else {
+			score = powf(1.f - (cachePos - 3) / GLfloat(VERTEX_CACHE_SIZE - 3), 1.5f);
+		}
+	}
+	return score + 2.f / sqrtf(GLfloat(remaining));
+}
+
+void optimizeVertexCache(std::vector<GLuint> & indices, size_t vertexCount) {
+	/*
+	Greedily emits the best scoring triangle among those touching the simulated cache, recomputing
+	scores only for the vertices in it; when none is left it continues with the next unemitted triangle
+	*/
+	size_t triCount = indices.size() / 3;
+	if (triCount == 0) {
+		return;
+	}
+
+	// triangles of each vertex: adjacency[offset[v], offset[v] + remaining[v]) holds the ones not emitted yet
+	std::vector<GLuint> remaining(vertexCount, 0), offset(vertexCount + 1, 0), adjacency(indices.size());
+	for (GLuint i : indices) {
+		remaining[i]++;
+	}
+	for (size_t v = 0; v < vertexCount; v++) {
+		offset[v + 1] = offset[v] + remaining[v];
+	}
+	std::vector<GLuint> fill(offset.begin(), offset.end() - 1);
+	for (size_t i = 0; i < indices.size(); i++) {
+		adjacency[fill[indices[i]]++] = GLuint(i / 3);
+	}
+
+	std::vector<int> cachePos(vertexCount, -1);
+	std::vector<GLfloat> score(vertexCount);
+	for (size_t v = 0; v < vertexCount; v++) {
+		score[v] = vertexScore(-1, remaining[v]);
+	}
+	std::vector<GLfloat> triScore(triCount);
+	for (size_t t = 0; t < triCount; t++) {
+		triScore[t] = score[indices[3 * t]] + score[indices[3 * t + 1]] + score[indices[3 * t + 2]];
+	}
+
+	std::vector<bool> emitted(triCount, false);
+	std::vector<GLuint> out, cache, next;
+	out.reserve(indices.size());
+	cache.reserve(VERTEX_CACHE_SIZE + 3);
+	size_t cursor = 0;
+	long best = 0;
+
+	while (out.size() < indices.size()) {
+		if (best < 0) {
+			while (emitted[cursor]) {
+				cursor++;
+			}
+			best = long(cursor);
+		}
+
+		const GLuint * tri = &indices[3 * best];
+		emitted[best] = true;
+		for (int k = 0; k < 3; k++) {
+			GLuint v = tri[k];
+			out.push_back(v);
+			GLuint * first = &adjacency[offset[v]], *last = first + remaining[v] - 1;
+			*std::find(first, last + 1, GLuint(best)) = *last;
+			remaining[v]--;
+		}
+
+		// the triangle's vertices move to the front, everything else shifts back by up to three
+		next.assign(tri, tri + 3);
+		for (GLuint v : cache) {
+			if (v != tri[0] && v != tri[1] && v != tri[2]) {
+				next.push_back(v);
+			}
+		}
+		cache.swap(next);
+		for (size_t i = 0; i < cache.size(); i++) {
+			GLuint v = cache[i];
+			cachePos[v] = i < VERTEX_CACHE_SIZE ? int(i) : -1;
+			score[v] = vertexScore(cachePos[v], remaining[v]);
+		}
+
+		best = -1;
+		GLfloat bestScore = -1.f;
+		for (GLuint v : cache) {
+			for (GLuint j = offset[v]; j < offset[v] + remaining[v]; j++) {
+				GLuint t = adjacency[j];
+				triScore[t] = score[indices[3 * t]] + score[indices[3 * t + 1]] + score[indices[3 * t + 2]];
+				if (triScore[t] > bestScore) {
+					bestScore = triScore[t];
+					best = t;
+				}
+			}
+		}
+		if (cache.size() > VERTEX_CACHE_SIZE) {
+			cache.resize(VERTEX_CACHE_SIZE);
+		}
+	}
+
+	indices.swap(out);
+}
+
+CacheStats cacheStats(const std::vector<GLuint> & indices, size_t vertexCount, int cacheSize) {
+	std::vector<long> loadedAt(vertexCount, -1);	// miss counter at which each vertex entered the FIFO
+	long misses = 0;
+	for (GLuint i : indices) {
+		if (loadedAt[i] < 0 || misses - loadedAt[i] >= cacheSize) {
+			loadedAt[i] = misses++;
+		}
+	}
+	CacheStats stats;
+	stats.acmr = indices.empty() ? 0.f : GLfloat(misses) / (indices.size() / 3);
+	stats.atvr = vertexCount == 0 ? 0.f : GLfloat(misses) / vertexCount;
+	return stats;
+}
+
+GLenum uploadIndices(const std::vector<GLuint> & indices, size_t vertexCount) {
+	if (vertexCount <= 0x10000) {
+		std::vector<GLushort> shorts(indices.begin(), indices.end());
+		glBufferData(GL_ELEMENT_ARRAY_BUFFER, shorts.size() * sizeof(GLushort), shorts.data(), GL_STATIC_DRAW);
+		return GL_UNSIGNED_SHORT;
+	}
+	glBufferData(GL_ELEMENT_ARRAY_BUFFER, indices.size() * sizeof(GLuint), indices.data(), GL_STATIC_DRAW);
+	return GL_UNSIGNED_INT;
+}
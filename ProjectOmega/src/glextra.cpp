@@ -0,0 +1,76 @@
+#include <glextra.h>
+#include <cstring>
+
+#ifndef GL_VERSION_4_0
+PFNGLPATCHPARAMETERIPROC glad_glPatchParameteri = NULL;
+#endif
+
+#ifndef GL_VERSION_4_1
+PFNGLGETPROGRAMBINARYPROC glad_glGetProgramBinary = NULL;
+PFNGLPROGRAMBINARYPROC glad_glProgramBinary = NULL;
+PFNGLPROGRAMPARAMETERIPROC glad_glProgramParameteri = NULL;
+#endif
+
+#ifndef GL_VERSION_4_3
+PFNGLDISPATCHCOMPUTEPROC glad_glDispatchCompute = NULL;
+PFNGLBINDIMAGETEXTUREPROC glad_glBindImageTexture = NULL;
+PFNGLMEMORYBARRIERPROC glad_glMemoryBarrier = NULL;
+#endif
+
+#ifndef GL_VERSION_4_4
+PFNGLBUFFERSTORAGEPROC glad_glBufferStorage = NULL;
+#endif
+
+GLExtras glExtras;
+
+static bool hasVersion(int major, int minor) {
+	return GLVersion.major > major || (GLVersion.major == major && GLVersion.minor >= minor);
+}
+
+bool hasGLExtension(const char * name) {
+	GLint count = 0;
+	glGetIntegerv(GL_NUM_EXTENSIONS, &count);
+	for (GLint i = 0; i < count; i++) {
+		const char * ext = (const char *)glGetStringi(GL_EXTENSIONS, i);
+		if (ext && strcmp(ext, name) == 0) {
+			return true;
+		}
+	}
+	return false;
+}
+
+void loadGLExtras(GLADloadproc load) {
+	glExtras = GLExtras();
+
+	// the tessellation shaders are #version 400 like the compute ones are 430
+	if (hasVersion(4, 0)) {
+		glad_glPatchParameteri = (PFNGLPATCHPARAMETERIPROC)load("glPatchParameteri");
+		GLint level = 0;
+		glGetIntegerv(GL_MAX_TESS_GEN_LEVEL, &level);
+		glExtras.tessellation = glad_glPatchParameteri && level >= 64;
+	}
+
+	if (hasVersion(4, 1) || hasGLExtension("GL_ARB_get_program_binary")) {
+		glad_glGetProgramBinary = (PFNGLGETPROGRAMBINARYPROC)load("glGetProgramBinary");
+		glad_glProgramBinary = (PFNGLPROGRAMBINARYPROC)load("glProgramBinary");
+		glad_glProgramParameteri = (PFNGLPROGRAMPARAMETERIPROC)load("glProgramParameteri");
+		GLint formats = 0;
+		glGetIntegerv(GL_NUM_PROGRAM_BINARY_FORMATS, &formats);
+		glExtras.programBinary = glad_glGetProgramBinary && glad_glProgramBinary && glad_glProgramParameteri && formats > 0;
+	}
+
+	// the compute shaders are #version 430, so the ARB extensions on an older context are not enough
+	if (hasVersion(4, 3)) {
+		glad_glDispatchCompute = (PFNGLDISPATCHCOMPUTEPROC)load("glDispatchCompute");
+		glad_glBindImageTexture = (PFNGLBINDIMAGETEXTUREPROC)load("glBindImageTexture");
+		glad_glMemoryBarrier = (PFNGLMEMORYBARRIERPROC)load("glMemoryBarrier");
+		GLint shared = 0;
+		glGetIntegerv(GL_MAX_COMPUTE_SHARED_MEMORY_SIZE, &shared);
+		glExtras.compute = glad_glDispatchCompute && glad_glBindImageTexture && glad_glMemoryBarrier && shared >= 32768;
+	}
+
+	if (hasVersion(4, 4) || hasGLExtension("GL_ARB_buffer_storage")) {
+		glad_glBufferStorage = (PFNGLBUFFERSTORAGEPROC)load("glBufferStorage");
+		glExtras.bufferStorage = glad_glBufferStorage != NULL;
+	}
+}
@@ -0,0 +1,124 @@
+#include <glstate.h>
+#include <algorithm>
+
+#define GL_STATE_UNKNOWN 0xFFFFFFFFu	// no GL name or enum takes this value
+
+GLState glState;
+
+static bool changed(bool differs) {
+	// counts the call either way, the callers only reach GL when it returns true
+	if (differs) {
+		glState.calls++;
+	}
+	else {
+		glState.skipped++;
+	}
+	return differs;
+}
+
+void invalidateGLState() {
+	glState.program = glState.vao = glState.fbo = GL_STATE_UNKNOWN;
+	glState.unit = GL_STATE_UNKNOWN;
+	std::fill(&glState.textures[0][0], &glState.textures[0][0] + GL_STATE_UNITS * GL_STATE_TARGETS, GL_STATE_UNKNOWN);
+	glState.depthTest = glState.cullFace = glState.scissorTest = -1;
+	glState.frontFace = glState.depthFunc = GL_STATE_UNKNOWN;
+	std::fill(glState.viewport, glState.viewport + 4, -1);
+}
+
+void useProgram(GLuint program) {
+	if (changed(glState.program != program)) {
+		glUseProgram(program);
+		glState.program = program;
+	}
+}
+
+void bindVertexArray(GLuint vao) {
+	if (changed(glState.vao != vao)) {
+		glBindVertexArray(vao);
+		glState.vao = vao;
+	}
+}
+
+void bindFramebuffer(GLuint fbo) {
+	if (changed(glState.fbo != fbo)) {
+		glBindFramebuffer(GL_FRAMEBUFFER, fbo);
+		glState.fbo = fbo;
+	}
+}
+
+static int targetIndex(GLenum target) {
+	switch (target) {
+	case GL_TEXTURE_2D: return 0;
+	case GL_TEXTURE_CUBE_MAP: return 1;
+	default: return -1;
+	}
+}
+
+void bindTexture(GLuint unit, GLenum target, GLuint texture) {
+	int t = targetIndex(target);
+	bool tracked = unit < GL_STATE_UNITS && t >= 0;
+	if (tracked && !changed(glState.textures[unit][t] != texture)) {
+		return;
+	}
+	activeTexture(unit);
+	glBindTexture(target, texture);
+	if (tracked) {
+		glState.textures[unit][t] = texture;
+	}
+	else {
+		glState.calls++;
+	}
+}
+
+void activeTexture(GLuint unit) {
+	if (changed(glState.unit != unit)) {
+		glActiveTexture(GL_TEXTURE0 + unit);
+		glState.unit = unit;
+	}
+}
+
+void setCapability(GLenum cap, bool enabled) {
+	GLint * shadow = cap == GL_DEPTH_TEST ? &glState.depthTest
+		: cap == GL_CULL_FACE ? &glState.cullFace
+		: cap == GL_SCISSOR_TEST ? &glState.scissorTest : NULL;
+	if (shadow && !changed(*shadow != GLint(enabled))) {
+		return;
+	}
+	if (enabled) {
+		glEnable(cap);
+	}
+	else {
+		glDisable(cap);
+	}
+	if (shadow) {
+		*shadow = enabled;
+	}
+	else {
+		glState.calls++;
+	}
+}
+
+void setFrontFace(GLenum mode) {
+	if (changed(glState.frontFace != mode)) {
+		glFrontFace(mode);
+		glState.frontFace = mode;
+	}
+}
+
+void setDepthFunc(GLenum func) {
+	if (changed(glState.depthFunc != func)) {
+		glDepthFunc(func);
+		glState.depthFunc = func;
+	}
+}
+
+void setViewport(GLint x, GLint y, GLsizei width, GLsizei height) {
+	GLint * v = glState.viewport;
+	if (changed(v[0] != x || v[1] != y || v[2] != width || v[3] != height)) {
+		glViewport(x, y, width, height);
+		v[0] = x;
+		v[1] = y;
+		v[2] = width;
+		v[3] = height;
+	}
+}
@@ -0,0 +1,115 @@
+#include <log.h>
+#include <chrono>
+#include <cstdarg>
+#include <cstdio>
+#include <cstdlib>
+
+Logger logger;
+
+static void writeEntry(LogLevel level, const char * text) {
+	FILE * out = level >= LOG_WARN ? stderr : stdout;
+	fputs(text, out);
+	fputc('\n', out);
+}
+
+static void drainLog() {
+	/*
+	Writes the queued entries; flushing once per batch is the only place the log waits on I/O
+	*/
+	for (;;) {
+		bool running = logger.running.load(std::memory_order_acquire);
+		unsigned tail = logger.tail.load(std::memory_order_relaxed), head = logger.head.load(std::memory_order_acquire);
+		for (; tail != head; tail++) {
+			const LogEntry & e = logger.ring[tail % LOG_RING];
+			writeEntry(e.level, e.text);
+			logger.tail.store(tail + 1, std::memory_order_release);
+		}
+		unsigned dropped = logger.dropped.exchange(0);
+		if (dropped) {
+			fprintf(stderr, "Log: %u messages dropped\n", dropped);
+		}
+		fflush(stdout);
+		fflush(stderr);
+		if (!running) {
+			return;
+		}
+		if (logger.head.load(std::memory_order_acquire) == tail) {
+			std::this_thread::sleep_for(std::chrono::milliseconds(LOG_POLL_MS));
+		}
+	}
+}
+
+void startLogger(LogLevel level) {
+	static bool registered = false;
+	logger.level = level;
+	if (logger.running) {
+		return;
+	}
+	logger.running = true;
+	logger.drain = std::thread(drainLog);
+	if (!registered) {
+		atexit(stopLogger);
+		registered = true;
+	}
+}
+
+void stopLogger() {
+	if (!logger.running) {
+		return;
+	}
+	logger.running.store(false, std::memory_order_release);
+	logger.drain.join();
+}
+
+static void formatEntry(char * text, const char * format, va_list args, unsigned suppressed) {
+	int length = vsnprintf(text, LOG_LINE, format, args);
+	if (suppressed && length >= 0 && length < LOG_LINE) {
+		snprintf(text + length, LOG_LINE - length, " (%u similar messages suppressed)", suppressed);
+	}
+}
+
+static void logFormatted(LogLevel level, const char * fmt, va_list args, unsigned suppressed) {
+	if (!logger.running.load(std::memory_order_relaxed)) {
+		char text[LOG_LINE];
+		formatEntry(text, fmt, args, suppressed);
+		writeEntry(level, text);
+		return;
+	}
+
+	unsigned head = logger.head.load(std::memory_order_relaxed);
+	if (head - logger.tail.load(std::memory_order_acquire) >= LOG_RING) {
+		logger.dropped.fetch_add(1, std::memory_order_relaxed);
+		return;
+	}
+	LogEntry & e = logger.ring[head % LOG_RING];
+	e.level = level;
+	formatEntry(e.text, fmt, args, suppressed);
+	logger.head.store(head + 1, std::memory_order_release);
+}
+
+void logMessage(LogLevel level, const char * format, ...) {
+	if (level < logger.level) {
+		return;
+	}
+	va_list args;
+	va_start(args, format);
+	logFormatted(level, format, args, 0);
+	va_end(args);
+}
+
+void logLimited(LogLimit & limit, LogLevel level, const char * format, ...) {
+	if (level < logger.level) {
+		return;
+	}
+	double now = std::chrono::duration<double>(std::chrono::steady_clock::now().time_since_epoch()).count();
+	if (now < limit.next) {
+		limit.suppressed++;
+		return;
+	}
+	limit.next = now + limit.interval;
+	va_list args;
+	va_start(args, format);
+	logFormatted(level, format, args, limit.suppressed);
+	va_end(args);
+	limit.suppressed = 0;
+}
@@ -0,0 +1,80 @@
+#include <matrix.h>
+
+Vector4 multiply(Matrix4 a, Vector4 b) {
+	// returns vector AB
+	GLfloat res[4];
+	GLfloat vec[4] = { b.x, b.y, b.z, b.w };
+	for (int i = 0; i < 4; i++) {
+		// for each vector element
+		GLfloat ans = 0;
+		for (int j = 0; j < 4; j++) {
+			ans += a.data[i + 4 * j] * vec[j];
+		}
+		res[i] = ans;
+	}
+	return Vector4(res[0], res[1], res[2], res[3]);
+}
+
+Matrix4 multiply(Matrix4 a, Matrix4 b) {
+	Matrix4 result;
+	// returns AB
+	for (int row = 0; row < 4; row++) {
+		for (int col = 0; col < 4; col++) {
+			GLfloat val = 0;
+			for (int i = 0; i < 4; i++) {
+				val += a.get(row, i) * b.get(i, col);
+			}
+			result.set(row, col, val);
+		}
+	}
+	return result;
+}
+
+Matrix4 rotate(Matrix4 mat, GLfloat a, GLfloat x, GLfloat y, GLfloat z) {
+	// creates a matrix B that rotaties by amount a in degrees in the given normalized arbitrary axis (x, y, z)
+	// returns multiply(B, MAT)
+
+	// convert the angle to radians
+	GLfloat angle = a * PI / 180.f;
+
+	// normalize the direction vector
+	GLfloat mag = sqrt(x * x + y * y + z * z);
+	x /= mag;
+	y /= mag;
+	z /= mag;
+
+	Matrix4 result;
+	result.set(0, 0, x * x * (1 - cos(angle)) + cos(angle));
+	result.set(1, 0, y * x * (1 - cos(angle)) + z * sin(angle));
+	result.set(2, 0, z * x * (1 - cos(angle)) - y * sin(angle));
+
+	result.set(0, 1, x * y * (1 - cos(angle)) - z * sin(angle));
+	result.set(1, 1, y * y * (1 - cos(angle)) + cos(angle));
+	result.set(2, 1, z * y * (1 - cos(angle)) + x * sin(angle));
+
+	result.set(0, 2, x * z * (1 - cos(angle)) + y * sin(angle));
+	result.set(1, 2, y * z * (1 - cos(angle)) - x * sin(angle));
+	result.set(2, 2, z * z * (1 - cos(angle)) + cos(angle));
+
+	return multiply(mat, result);
+}
+
+Matrix4 translate(Matrix4 mat, GLfloat x, GLfloat y, GLfloat z) {
+	// creates a matrix B that translates in x-, y-, z-axis by amount denoted by inputs x, y, z
+	// returns multiply(B, MAT)
+	Matrix4 result;
+	result.set(0, 3, x);
+	result.set(1, 3, y);
+	result.set(2, 3, z);
+	return multiply(mat, result);
+}
+
+Matrix4 scale(Matrix4 mat, GLfloat x, GLfloat y, GLfloat z) {
+	// creates a scaling matrix b that scales values in the respective axes by the respective inputs
+	// returns multiply(B, MAT)
+	Matrix4 result;
+	result.set(0, 0, x);
+	result.set(1, 1, y);
+	result.set(2, 2, z);
+	return multiply(mat, result);
+}
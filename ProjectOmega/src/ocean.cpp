@@ -0,0 +1,428 @@
+#include <ocean.h>
+#include <glstate.h>
+#include <log.h>
+#include <shaders.h>
+#include <chrono>
+#include <cmath>
+#include <random>
+
+// SSE2 is the baseline of every x86-64 compiler; elsewhere the butterflies fall back to plain loops
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define OCEAN_SSE 1
+#include <emmintrin.h>
+#else
+#define OCEAN_SSE 0
+#endif
+
+#define OCEAN_STRIP 16		// columns per FFT work item, a multiple of the SIMD width
+#define OCEAN_TILE 16		// transpose block
+#define TWO_PI 6.2831853f
+
+static const int FIELD_PLANES = 6;	// real and imaginary planes of the three fields
+
+static GLfloat phillips(GLfloat kx, GLfloat kz) {
+	/*
+	Phillips spectrum: wind waves peak around the wavelength the wind speed supports, waves across the
+	wind are suppressed, and so are waves much shorter than that peak
+	*/
+	GLfloat k2 = kx * kx + kz * kz;
+	if (k2 < 1e-12f) {
+		return 0.f;
+	}
+	GLfloat peak = OCEAN_WIND * OCEAN_WIND / OCEAN_GRAVITY;
+	GLfloat along = kx * cos(OCEAN_WIND_DIR) + kz * sin(OCEAN_WIND_DIR);
+	GLfloat shortest = peak * 1e-3f;
+	return OCEAN_AMPLITUDE * exp(-1.f / (k2 * peak * peak)) / (k2 * k2) * (along * along / k2) * exp(-k2 * shortest * shortest);
+}
+
+static GLfloat waveNumber(int i, GLsizei n) {
+	// index i of an n-point transform holds frequency i, or i - n past the middle
+	return TWO_PI * (i < n / 2 ? i : i - n) / OCEAN_PATCH;
+}
+
+void setupOceanSpectrum(Ocean & o, GLsizei size, GLfloat extent) {
+	GLsizei n = 16;
+	while (n < glm::min(size, GLsizei(OCEAN_SIZE_MAX))) n *= 2;
+	o.size = n;
+	o.extent = extent;
+
+	// random phases and Gaussian amplitudes around the spectrum, then each wave vector's partner -k
+	std::mt19937 rng(OCEAN_SEED);
+	std::normal_distribution<GLfloat> gauss;
+	size_t nn = size_t(n) * n;
+	o.h0.assign(4 * nn, 0.f);
+	for (int z = 0; z < n; z++) {
+		for (int x = 0; x < n; x++) {
+			GLfloat a = sqrt(phillips(waveNumber(x, n), waveNumber(z, n)) * .5f);
+			GLfloat * h = &o.h0[4 * (size_t(z) * n + x)];
+			h[0] = gauss(rng) * a;
+			h[1] = gauss(rng) * a;
+		}
+	}
+	for (int z = 0; z < n; z++) {
+		for (int x = 0; x < n; x++) {
+			const GLfloat * mirror = &o.h0[4 * (size_t((n - z) % n) * n + (n - x) % n)];
+			GLfloat * h = &o.h0[4 * (size_t(z) * n + x)];
+			h[2] = mirror[0];
+			h[3] = -mirror[1];
+		}
+	}
+
+	o.twiddle.resize(n);
+	for (int i = 0; i < n / 2; i++) {
+		o.twiddle[2 * i] = cos(TWO_PI * i / n);
+		o.twiddle[2 * i + 1] = sin(TWO_PI * i / n);
+	}
+	for (std::vector<GLfloat> & p : o.planes) {
+		p.assign(FIELD_PLANES * nn, 0.f);
+	}
+	resetOceanStats(o);
+}
+
+bool oceanSse() {
+	return OCEAN_SSE;
+}
+
+void resetOceanStats(Ocean & o) {
+	o.runs = o.stalls = 0;
+	o.spectrumMs = o.fftMs = o.packMs = 0.0;
+}
+
+static void evaluateSpectrum(Ocean & o, WorkerPool & pool, GLfloat time) {
+	/*
+	h(k, t) = h0(k) e^(iwt) + conj(h0(-k)) e^(-iwt), and the fields built from it:
+	0: h + i (i kx h), 1: i kz h + i (-i kx / |k| h), 2: -i kz / |k| h
+	*/
+	GLsizei n = o.size;
+	size_t nn = size_t(n) * n;
+	GLfloat * p = o.planes[0].data();
+	parallelFor(pool, n, 8, [&](int begin, int end) {
+		for (int z = begin; z < end; z++) {
+			GLfloat kz = waveNumber(z, n);
+			for (int x = 0; x < n; x++) {
+				size_t i = size_t(z) * n + x;
+				const GLfloat * h = &o.h0[4 * i];
+				GLfloat kx = waveNumber(x, n), k = sqrt(kx * kx + kz * kz);
+				GLfloat w = sqrt(OCEAN_GRAVITY * k) * time, c = cos(w), s = sin(w);
+				GLfloat hr = h[0] * c - h[1] * s + h[2] * c + h[3] * s;
+				GLfloat hi = h[0] * s + h[1] * c - h[2] * s + h[3] * c;
+				GLfloat ux = k > 0.f ? kx / k : 0.f, uz = k > 0.f ? kz / k : 0.f;
+				p[i] = (1.f - kx) * hr;
+				p[nn + i] = (1.f - kx) * hi;
+				p[2 * nn + i] = ux * hr - kz * hi;
+				p[3 * nn + i] = ux * hi + kz * hr;
+				p[4 * nn + i] = uz * hi;
+				p[5 * nn + i] = -uz * hr;
+			}
+		}
+	});
+}
+
+static void butterflies(int c0, int c1, GLfloat wr, GLfloat wi, const GLfloat * ar, const GLfloat * ai, const GLfloat * br, const GLfloat * bi,
+	GLfloat * sumr, GLfloat * sumi, GLfloat * difr, GLfloat * difi) {
+	// a +- w b over columns c0..c1-1
+#if OCEAN_SSE
+	__m128 vwr = _mm_set1_ps(wr), vwi = _mm_set1_ps(wi);
+	for (int c = c0; c < c1; c += 4) {
+		__m128 xr = _mm_loadu_ps(ar + c), xi = _mm_loadu_ps(ai + c), yr = _mm_loadu_ps(br + c), yi = _mm_loadu_ps(bi + c);
+		__m128 tr = _mm_sub_ps(_mm_mul_ps(yr, vwr), _mm_mul_ps(yi, vwi));
+		__m128 ti = _mm_add_ps(_mm_mul_ps(yr, vwi), _mm_mul_ps(yi, vwr));
+		_mm_storeu_ps(sumr + c, _mm_add_ps(xr, tr));
+		_mm_storeu_ps(sumi + c, _mm_add_ps(xi, ti));
+		_mm_storeu_ps(difr + c, _mm_sub_ps(xr, tr));
+		_mm_storeu_ps(difi + c, _mm_sub_ps(xi, ti));
+	}
+#else
+	for (int c = c0; c < c1; c++) {
+		GLfloat tr = br[c] * wr - bi[c] * wi, ti = br[c] * wi + bi[c] * wr;
+		sumr[c] = ar[c] + tr;
+		sumi[c] = ai[c] + ti;
+		difr[c] = ar[c] - tr;
+		difi[c] = ai[c] - ti;
+	}
+#endif
+}
+
+static int transformColumns(Ocean & o, WorkerPool & pool, int src) {
+	/*
+	Inverse FFT down every column of the three fields, radix-2 Stockham so no reordering pass is needed:
+	stage Ns combines element j and j + n/2 into 2 (j - j % Ns) + j % Ns and that plus Ns. Columns are
+	independent, so each strip of OCEAN_STRIP runs every stage on its own. Returns the buffer with the result
+	*/
+	GLsizei n = o.size, half = n / 2;
+	size_t nn = size_t(n) * n;
+	int stages = 0;
+	while ((1 << stages) < n) stages++;
+	parallelFor(pool, n / OCEAN_STRIP, 1, [&](int begin, int end) {
+		for (int strip = begin; strip < end; strip++) {
+			int c0 = strip * OCEAN_STRIP, c1 = c0 + OCEAN_STRIP;
+			int from = src;
+			for (int ns = 1; ns < n; ns *= 2) {
+				const GLfloat * in = o.planes[from].data();
+				GLfloat * out = o.planes[from ^ 1].data();
+				for (int j = 0; j < half; j++) {
+					int k = j & (ns - 1), d = 2 * (j - k) + k, t = k * (half / ns);
+					for (int f = 0; f < FIELD_PLANES; f += 2) {
+						const GLfloat * ar = in + f * nn + size_t(j) * n, * ai = ar + nn;
+						GLfloat * sumr = out + f * nn + size_t(d) * n, * sumi = sumr + nn;
+						butterflies(c0, c1, o.twiddle[2 * t], o.twiddle[2 * t + 1], ar, ai, ar + size_t(half) * n, ai + size_t(half) * n,
+							sumr, sumi, sumr + size_t(ns) * n, sumi + size_t(ns) * n);
+					}
+				}
+				from ^= 1;
+			}
+		}
+	});
+	return src ^ (stages & 1);
+}
+
+static void transpose(Ocean & o, WorkerPool & pool, int src) {
+	GLsizei n = o.size;
+	size_t nn = size_t(n) * n;
+	const GLfloat * in = o.planes[src].data();
+	GLfloat * out = o.planes[src ^ 1].data();
+	parallelFor(pool, n / OCEAN_TILE, 1, [&](int begin, int end) {
+		for (int by = begin * OCEAN_TILE; by < end * OCEAN_TILE; by += OCEAN_TILE) {
+			for (int bx = 0; bx < n; bx += OCEAN_TILE) {
+				for (int f = 0; f < FIELD_PLANES; f++) {
+					const GLfloat * a = in + f * nn;
+					GLfloat * b = out + f * nn;
+					for (int y = by; y < by + OCEAN_TILE; y++) {
+						for (int x = bx; x < bx + OCEAN_TILE; x++) {
+							b[size_t(x) * n + y] = a[size_t(y) * n + x];
+						}
+					}
+				}
+			}
+		}
+	});
+}
+
+static double msSince(std::chrono::steady_clock::time_point & since) {
+	auto now = std::chrono::steady_clock::now();
+	double ms = std::chrono::duration<double, std::milli>(now - since).count();
+	since = now;
+	return ms;
+}
+
+void simulateOcean(Ocean & o, WorkerPool & pool, GLfloat time, GLfloat * out) {
+	/*
+	Spectrum, transforms down the columns (along z), a transpose, transforms down the columns again
+	(along x), and out of the transposed result into texture order
+	*/
+	auto start = std::chrono::steady_clock::now();
+	evaluateSpectrum(o, pool, time);
+	o.spectrumMs += msSince(start);
+
+	int src = transformColumns(o, pool, 0);
+	transpose(o, pool, src);
+	src = transformColumns(o, pool, src ^ 1);
+	o.fftMs += msSince(start);
+
+	GLsizei n = o.size;
+	size_t nn = size_t(n) * n;
+	const GLfloat * p = o.planes[src].data();
+	GLfloat scale = o.extent / OCEAN_PATCH, chop = -OCEAN_CHOP * scale;
+	GLfloat * normals = out + 4 * nn;
+	parallelFor(pool, n, 8, [&](int begin, int end) {
+		for (int z = begin; z < end; z++) {
+			for (int x = 0; x < n; x++) {
+				size_t i = size_t(x) * n + z, t = size_t(z) * n + x;
+				out[4 * t] = chop * p[3 * nn + i];
+				out[4 * t + 1] = scale * p[i];
+				out[4 * t + 2] = chop * p[4 * nn + i];
+				out[4 * t + 3] = 0.f;
+				normals[2 * t] = p[nn + i];
+				normals[2 * t + 1] = p[2 * nn + i];
+			}
+		}
+	});
+	o.packMs += msSince(start);
+	o.runs++;
+}
+
+static void makeTexture(GLuint * tex, GLenum internalFormat, GLenum format, GLsizei n, GLint wrap, const void * data) {
+	glGenTextures(1, tex);
+	glBindTexture(GL_TEXTURE_2D, *tex);
+	glTexImage2D(GL_TEXTURE_2D, 0, internalFormat, n, n, 0, format, GL_FLOAT, data);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, wrap == GL_REPEAT ? GL_LINEAR : GL_NEAREST);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, wrap == GL_REPEAT ? GL_LINEAR : GL_NEAREST);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, wrap);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, wrap);
+}
+
+static void makeTargets(GLuint * fbo, GLuint color0, GLuint color1) {
+	static const GLenum buffers[] = { GL_COLOR_ATTACHMENT0, GL_COLOR_ATTACHMENT1 };
+	glGenFramebuffers(1, fbo);
+	glBindFramebuffer(GL_FRAMEBUFFER, *fbo);
+	glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, color0, 0);
+	glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT1, GL_TEXTURE_2D, color1, 0);
+	glDrawBuffers(2, buffers);
+
+	auto status = glCheckFramebufferStatus(GL_FRAMEBUFFER);
+	if (status != GL_FRAMEBUFFER_COMPLETE) {
+		logMessage(LOG_ERROR, "Cannot setup ocean framebuffer (incomplete): %u.", status);
+	}
+}
+
+void releaseOcean(Ocean & o) {
+	GLuint texs[] = { o.displacement, o.normals, o.h0Tex, o.tex[0][0], o.tex[0][1], o.tex[1][0], o.tex[1][1] };
+	for (GLuint t : texs) {
+		if (t) glDeleteTextures(1, &t);
+	}
+	GLuint fbos[] = { o.fbo[0], o.fbo[1], o.outFbo };
+	for (GLuint f : fbos) {
+		if (f) glDeleteFramebuffers(1, &f);
+	}
+	for (int i = 0; i < OCEAN_UPLOADS; i++) {
+		if (o.fences[i]) glDeleteSync(o.fences[i]);
+		if (o.pbo[i]) glDeleteBuffers(1, &o.pbo[i]);
+		o.fences[i] = 0;
+		o.pbo[i] = 0;
+	}
+	o.displacement = o.normals = o.h0Tex = o.outFbo = 0;
+	o.fbo[0] = o.fbo[1] = 0;
+	o.tex[0][0] = o.tex[0][1] = o.tex[1][0] = o.tex[1][1] = 0;
+	invalidateGLState();
+}
+
+void setupOcean(Ocean & o, GLsizei size, GLfloat extent, bool gpu) {
+	/*
+	(Re)allocates the textures the water samples and whatever the chosen path needs to fill them
+	*/
+	releaseOcean(o);
+	setupOceanSpectrum(o, size, extent);
+	o.gpu = gpu;
+	GLsizei n = o.size;
+	size_t nn = size_t(n) * n;
+
+	glActiveTexture(GL_TEXTURE0 + OCEAN_UNIT);
+	makeTexture(&o.displacement, GL_RGBA32F, GL_RGBA, n, GL_REPEAT, NULL);
+	glActiveTexture(GL_TEXTURE0 + OCEAN_UNIT + 1);
+	makeTexture(&o.normals, GL_RG32F, GL_RG, n, GL_REPEAT, NULL);
+
+	if (!gpu) {
+		glGenBuffers(OCEAN_UPLOADS, o.pbo);
+		for (int i = 0; i < OCEAN_UPLOADS; i++) {
+			glBindBuffer(GL_PIXEL_UNPACK_BUFFER, o.pbo[i]);
+			glBufferData(GL_PIXEL_UNPACK_BUFFER, 6 * nn * sizeof(GLfloat), NULL, GL_STREAM_DRAW);
+		}
+		glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+		o.next = 0;
+		invalidateGLState();
+		return;
+	}
+
+	// the transforms ping-pong between two pairs of targets, fields 0 and 1 in one, field 2 in the other
+	o.planes[0].clear();
+	o.planes[1].clear();
+	makeTexture(&o.h0Tex, GL_RGBA32F, GL_RGBA, n, GL_CLAMP_TO_EDGE, o.h0.data());
+	for (int i = 0; i < 2; i++) {
+		makeTexture(&o.tex[i][0], GL_RGBA32F, GL_RGBA, n, GL_CLAMP_TO_EDGE, NULL);
+		makeTexture(&o.tex[i][1], GL_RG32F, GL_RG, n, GL_CLAMP_TO_EDGE, NULL);
+		makeTargets(&o.fbo[i], o.tex[i][0], o.tex[i][1]);
+	}
+	makeTargets(&o.outFbo, o.displacement, o.normals);
+
+	if (!o.spectrumprogram) {
+		o.spectrumprogram = loadProgram("shaders/frame.vsh", "shaders/oceanspectrum.fsh");
+		o.s_h0 = glGetUniformLocation(o.spectrumprogram, "h0");
+		o.s_time = glGetUniformLocation(o.spectrumprogram, "time");
+		o.s_patch = glGetUniformLocation(o.spectrumprogram, "patch_size");
+		o.fftprogram = loadProgram("shaders/frame.vsh", "shaders/oceanfft.fsh");
+		o.f_a = glGetUniformLocation(o.fftprogram, "a");
+		o.f_b = glGetUniformLocation(o.fftprogram, "b");
+		o.f_stage = glGetUniformLocation(o.fftprogram, "stage");
+		o.f_vertical = glGetUniformLocation(o.fftprogram, "vertical");
+		o.resolveprogram = loadProgram("shaders/frame.vsh", "shaders/oceanresolve.fsh");
+		o.r_a = glGetUniformLocation(o.resolveprogram, "a");
+		o.r_b = glGetUniformLocation(o.resolveprogram, "b");
+		o.r_scale = glGetUniformLocation(o.resolveprogram, "scale");
+		o.r_chop = glGetUniformLocation(o.resolveprogram, "chop");
+	}
+	glUseProgram(o.spectrumprogram);
+	glUniform1i(o.s_h0, OCEAN_UNIT);
+	glUniform1f(o.s_patch, OCEAN_PATCH);
+	glUseProgram(o.fftprogram);
+	glUniform1i(o.f_a, OCEAN_UNIT);
+	glUniform1i(o.f_b, OCEAN_UNIT + 1);
+	glUseProgram(o.resolveprogram);
+	glUniform1i(o.r_a, OCEAN_UNIT);
+	glUniform1i(o.r_b, OCEAN_UNIT + 1);
+	glUniform1f(o.r_scale, o.extent / OCEAN_PATCH);
+	glUniform1f(o.r_chop, -OCEAN_CHOP);
+	invalidateGLState();
+}
+
+static void runOceanGpu(Ocean & o, GLfloat time, GLuint screenVAO) {
+	/*
+	The spectrum pass, log2(size) stages down the columns and as many along the rows, and the resolve pass
+	into the displacement and normal textures. Leaves the viewport at the ocean size
+	*/
+	bindVertexArray(screenVAO);
+	setViewport(0, 0, o.size, o.size);
+	bindTexture(OCEAN_UNIT, GL_TEXTURE_2D, o.h0Tex);
+	bindFramebuffer(o.fbo[0]);
+	useProgram(o.spectrumprogram);
+	glUniform1f(o.s_time, time);
+	glDrawArrays(GL_TRIANGLE_STRIP, 0, 4);
+
+	int current = 0;
+	useProgram(o.fftprogram);
+	for (int vertical = 1; vertical >= 0; vertical--) {
+		glUniform1i(o.f_vertical, vertical);
+		for (int stage = 0; (1 << stage) < o.size; stage++) {
+			glUniform1i(o.f_stage, stage);
+			bindTexture(OCEAN_UNIT, GL_TEXTURE_2D, o.tex[current][0]);
+			bindTexture(OCEAN_UNIT + 1, GL_TEXTURE_2D, o.tex[current][1]);
+			current ^= 1;
+			bindFramebuffer(o.fbo[current]);
+			glDrawArrays(GL_TRIANGLE_STRIP, 0, 4);
+		}
+	}
+
+	bindTexture(OCEAN_UNIT, GL_TEXTURE_2D, o.tex[current][0]);
+	bindTexture(OCEAN_UNIT + 1, GL_TEXTURE_2D, o.tex[current][1]);
+	bindFramebuffer(o.outFbo);
+	useProgram(o.resolveprogram);
+	glDrawArrays(GL_TRIANGLE_STRIP, 0, 4);
+}
+
+void runOcean(Ocean & o, WorkerPool & pool, GLfloat time, GLuint screenVAO) {
+	if (o.gpu) {
+		runOceanGpu(o, time, screenVAO);
+	}
+	else {
+		// the oldest buffer of the ring: its fence has normally long passed, waiting on it is counted
+		GLsizei n = o.size;
+		size_t nn = size_t(n) * n;
+		GLsync & fence = o.fences[o.next];
+		if (fence) {
+			if (glClientWaitSync(fence, 0, 0) == GL_TIMEOUT_EXPIRED) {
+				o.stalls++;
+				glClientWaitSync(fence, GL_SYNC_FLUSH_COMMANDS_BIT, GLuint64(-1));
+			}
+			glDeleteSync(fence);
+			fence = 0;
+		}
+		glBindBuffer(GL_PIXEL_UNPACK_BUFFER, o.pbo[o.next]);
+		GLfloat * out = (GLfloat *)glMapBufferRange(GL_PIXEL_UNPACK_BUFFER, 0, 6 * nn * sizeof(GLfloat),
+			GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_RANGE_BIT | GL_MAP_UNSYNCHRONIZED_BIT);
+		if (out) {
+			simulateOcean(o, pool, time, out);
+		}
+		glUnmapBuffer(GL_PIXEL_UNPACK_BUFFER);
+
+		bindTexture(OCEAN_UNIT, GL_TEXTURE_2D, o.displacement);
+		activeTexture(OCEAN_UNIT);
+		glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, n, n, GL_RGBA, GL_FLOAT, 0);
+		bindTexture(OCEAN_UNIT + 1, GL_TEXTURE_2D, o.normals);
+		activeTexture(OCEAN_UNIT + 1);
+		glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, n, n, GL_RG, GL_FLOAT, (void *)(4 * nn * sizeof(GLfloat)));
+		fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+		glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+		o.next = (o.next + 1) % OCEAN_UPLOADS;
+	}
+	bindTexture(OCEAN_UNIT, GL_TEXTURE_2D, o.displacement);
+	bindTexture(OCEAN_UNIT + 1, GL_TEXTURE_2D, o.normals);
+}
@@ -0,0 +1,77 @@
+#include <pacing.h>
+#include <glm/glm.hpp>
+
+void setupFramePacer(FramePacer & p) {
+	for (FrameContext & c : p.contexts) {
+		glGenQueries(2, c.queries);
+		c.fence = 0;
+	}
+	p.frames = glm::clamp(p.frames, 1, FRAME_CONTEXTS_MAX);
+	p.current = p.frames - 1;	// the first beginFrame starts at context 0
+	p.lastEnd = 0;
+	resetFramePacerStats(p);
+}
+
+void releaseFramePacer(FramePacer & p) {
+	for (FrameContext & c : p.contexts) {
+		if (c.fence) glDeleteSync(c.fence);
+		glDeleteQueries(2, c.queries);
+		c.fence = 0;
+	}
+}
+
+static double retireContext(FramePacer & p, FrameContext & c) {
+	/*
+	Waits for the context's frame and takes its timestamps; returns the milliseconds waited
+	*/
+	if (!c.fence) {
+		return 0.0;
+	}
+	auto start = std::chrono::steady_clock::now();
+	glClientWaitSync(c.fence, GL_SYNC_FLUSH_COMMANDS_BIT, GLuint64(-1));
+	double waited = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+	glDeleteSync(c.fence);
+	c.fence = 0;
+
+	GLuint64 t[2];
+	glGetQueryObjectui64v(c.queries[0], GL_QUERY_RESULT, &t[0]);
+	glGetQueryObjectui64v(c.queries[1], GL_QUERY_RESULT, &t[1]);
+	if (p.lastEnd) {
+		p.latestIdleMs = t[0] > p.lastEnd ? (t[0] - p.lastEnd) / 1e6 : 0.0;
+		p.idleMs += p.latestIdleMs;
+		p.idles++;
+	}
+	p.lastEnd = t[1];
+	return waited;
+}
+
+int beginFrame(FramePacer & p) {
+	p.current = (p.current + 1) % p.frames;
+	FrameContext & c = p.contexts[p.current];
+	p.latestWaitMs = retireContext(p, c);
+	p.waitMs += p.latestWaitMs;
+	p.waits++;
+	glQueryCounter(c.queries[0], GL_TIMESTAMP);
+	return p.current;
+}
+
+void endFrame(FramePacer & p) {
+	FrameContext & c = p.contexts[p.current];
+	glQueryCounter(c.queries[1], GL_TIMESTAMP);
+	c.fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+	glFlush();
+}
+
+void setFramesInFlight(FramePacer & p, int frames) {
+	// retire in submission order, oldest first, so the idle gaps stay in sequence
+	for (int i = 1; i <= p.frames; i++) {
+		retireContext(p, p.contexts[(p.current + i) % p.frames]);
+	}
+	p.frames = glm::clamp(frames, 1, FRAME_CONTEXTS_MAX);
+	p.current = p.frames - 1;
+}
+
+void resetFramePacerStats(FramePacer & p) {
+	p.waitMs = p.idleMs = 0.0;
+	p.waits = p.idles = 0;
+}
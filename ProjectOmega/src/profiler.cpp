@@ -0,0 +1,226 @@
+#include <profiler.h>
+#include <log.h>
+#include <algorithm>
+#include <cmath>
+#include <fstream>
+#include <sstream>
+
+static void writerLoop(Profiler & p) {
+	for (;;) {
+		std::string rows;
+		bool quit;
+		{
+			std::unique_lock<std::mutex> lock(p.mutex);
+			p.wake.wait(lock, [&] { return p.quit || !p.queued.empty(); });
+			rows.swap(p.queued);
+			quit = p.quit;
+		}
+		if (!rows.empty()) {
+			std::ofstream out(p.path, std::ios::app);
+			out << rows;
+		}
+		if (quit) {
+			return;
+		}
+	}
+}
+
+void setupProfiler(Profiler & p, const std::string & path, int reportEvery) {
+	releaseProfiler(p);
+	p.path = path;
+	p.reportEvery = reportEvery;
+	p.json = path.size() >= 5 && path.compare(path.size() - 5, 5, ".json") == 0;
+	glGenQueries(PROFILER_RING, p.frameQueries);
+	std::fill(p.framePending, p.framePending + PROFILER_RING, false);
+
+	// truncate the previous report
+	std::ofstream out(p.path, std::ios::trunc);
+	if (!out) {
+		logMessage(LOG_ERROR, "Cannot open profiler output %s", p.path.c_str());
+	}
+	else if (!p.json) {
+		out << "frame,pass,samples,gpu_min_ms,gpu_avg_ms,gpu_p99_ms,cpu_min_ms,cpu_avg_ms,cpu_p99_ms\n";
+	}
+	p.quit = false;
+	p.writer = std::thread(writerLoop, std::ref(p));
+}
+
+void releaseProfiler(Profiler & p) {
+	if (!p.writer.joinable()) {
+		return;
+	}
+	{
+		std::lock_guard<std::mutex> lock(p.mutex);
+		p.quit = true;
+	}
+	p.wake.notify_one();
+	p.writer.join();
+}
+
+Profiler::~Profiler() {
+	releaseProfiler(*this);
+}
+
+int profilerPass(Profiler & p, const std::string & name) {
+	/*
+	Registers a named pass and returns its id for profilerBegin / profilerEnd
+	*/
+	PassTimer t;
+	t.name = name;
+	glGenQueries(2 * PROFILER_RING, &t.queries[0][0]);
+	std::fill(t.pending, t.pending + PROFILER_RING, false);
+	p.passes.push_back(t);
+	return int(p.passes.size()) - 1;
+}
+
+double elapsedMs(std::chrono::steady_clock::time_point since) {
+	return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - since).count();
+}
+
+bool collectQueries(const GLuint * queries, int count, GLuint64 * results) {
+	/*
+	Reads count query results only if the last one is available (queries complete in order)
+	*/
+	GLint available = 0;
+	glGetQueryObjectiv(queries[count - 1], GL_QUERY_RESULT_AVAILABLE, &available);
+	if (!available) {
+		return false;
+	}
+	for (int i = 0; i < count; i++) {
+		glGetQueryObjectui64v(queries[i], GL_QUERY_RESULT, &results[i]);
+	}
+	return true;
+}
+
+void profilerBegin(Profiler & p, int pass) {
+	PassTimer & t = p.passes[pass];
+	if (t.pending[p.slot]) {
+		// the slot is PROFILER_RING frames old; take the result if it is there, never wait for it
+		GLuint64 r[2];
+		if (collectQueries(t.queries[p.slot], 2, r)) {
+			t.gpuMs.push_back((r[1] - r[0]) / 1e6);
+		}
+		else {
+			p.dropped++;
+		}
+		t.pending[p.slot] = false;
+	}
+	glQueryCounter(t.queries[p.slot][0], GL_TIMESTAMP);
+	t.cpuStart = std::chrono::steady_clock::now();
+}
+
+void profilerEnd(Profiler & p, int pass) {
+	PassTimer & t = p.passes[pass];
+	glQueryCounter(t.queries[p.slot][1], GL_TIMESTAMP);
+	t.cpuMs.push_back(elapsedMs(t.cpuStart));
+	t.pending[p.slot] = true;
+}
+
+void profilerFrameBegin(Profiler & p) {
+	p.latestFrameMs = 0.0;
+	if (p.framePending[p.slot]) {
+		GLuint64 r;
+		if (collectQueries(&p.frameQueries[p.slot], 1, &r)) {
+			p.latestFrameMs = r / 1e6;
+			p.frameMs.push_back(p.latestFrameMs);
+		}
+		else {
+			p.dropped++;
+		}
+		p.framePending[p.slot] = false;
+	}
+	glBeginQuery(GL_TIME_ELAPSED, p.frameQueries[p.slot]);
+	p.frameStart = std::chrono::steady_clock::now();
+}
+
+void profilerFinish(Profiler & p) {
+	/*
+	Waits for the GPU and collects every query still in flight (only for the end of a run, this stalls)
+	*/
+	glFinish();
+	for (int i = 0; i < PROFILER_RING; i++) {
+		for (PassTimer & t : p.passes) {
+			GLuint64 r[2];
+			if (t.pending[i] && collectQueries(t.queries[i], 2, r)) {
+				t.gpuMs.push_back((r[1] - r[0]) / 1e6);
+			}
+			t.pending[i] = false;
+		}
+		GLuint64 r;
+		if (p.framePending[i] && collectQueries(&p.frameQueries[i], 1, &r)) {
+			p.frameMs.push_back(r / 1e6);
+		}
+		p.framePending[i] = false;
+	}
+}
+
+void profilerReset(Profiler & p) {
+	/*
+	Drops the samples gathered so far, e.g. after warm-up frames
+	*/
+	for (PassTimer & t : p.passes) {
+		t.gpuMs.clear();
+		t.cpuMs.clear();
+	}
+	p.frameMs.clear();
+	p.frameCpuMs.clear();
+	p.dropped = 0;
+}
+
+PassStats passStats(std::vector<double> samples) {
+	PassStats s = { 0.0, 0.0, 0.0 };
+	if (samples.empty()) {
+		return s;
+	}
+	std::sort(samples.begin(), samples.end());
+	double total = 0.0;
+	for (double v : samples) total += v;
+	s.min = samples.front();
+	s.avg = total / samples.size();
+	s.p99 = samples[size_t(std::ceil(0.99 * samples.size())) - 1];
+	return s;
+}
+
+void writeProfilerReport(Profiler & p) {
+	std::ostringstream out;
+	auto row = [&](const std::string & name, std::vector<double> & gpu, std::vector<double> & cpu) {
+		PassStats g = passStats(gpu), c = passStats(cpu);
+		if (p.json) {
+			out << "{\"frame\":" << p.frame << ",\"pass\":\"" << name << "\",\"samples\":" << gpu.size()
+				<< ",\"gpu_min\":" << g.min << ",\"gpu_avg\":" << g.avg << ",\"gpu_p99\":" << g.p99
+				<< ",\"cpu_min\":" << c.min << ",\"cpu_avg\":" << c.avg << ",\"cpu_p99\":" << c.p99 << "}\n";
+		}
+		else {
+			out << p.frame << "," << name << "," << gpu.size() << "," << g.min << "," << g.avg << "," << g.p99
+				<< "," << c.min << "," << c.avg << "," << c.p99 << "\n";
+		}
+		gpu.clear();
+		cpu.clear();
+	};
+
+	for (PassTimer & t : p.passes) {
+		row(t.name, t.gpuMs, t.cpuMs);
+	}
+	row("frame", p.frameMs, p.frameCpuMs);
+
+	{
+		std::lock_guard<std::mutex> lock(p.mutex);
+		p.queued += out.str();
+	}
+	p.wake.notify_one();
+}
+
+void profilerFrameEnd(Profiler & p) {
+	/*
+	Closes the frame: ends the frame query, advances the ring and writes a report every reportEvery frames
+	*/
+	glEndQuery(GL_TIME_ELAPSED);
+	p.frameCpuMs.push_back(elapsedMs(p.frameStart));
+	p.framePending[p.slot] = true;
+
+	p.slot = (p.slot + 1) % PROFILER_RING;
+	p.frame++;
+	if (p.reportEvery > 0 && p.frame % p.reportEvery == 0) {
+		writeProfilerReport(p);
+	}
+}
@@ -0,0 +1,33 @@
+#include <resolution.h>
+#include <algorithm>
+#include <cmath>
+
+GLfloat updateDynamicResolution(DynamicResolution & d, double gpuMs) {
+	/*
+	The cost model is plain fill rate (time proportional to the pixel count, i.e. to scale squared), which
+	overestimates the gain of scaling down when vertex work dominates; the window and the RESOLUTION_LOW band
+	keep that from oscillating, the worst case is one step back and forth every 2 * RESOLUTION_WINDOW frames
+	*/
+	if (d.budgetMs <= 0.f || gpuMs <= 0.0) {
+		return d.scale;
+	}
+	if (d.samples++ < 0) {
+		return d.scale;
+	}
+	d.smoothedMs = d.samples == 1 ? gpuMs : d.smoothedMs + (gpuMs - d.smoothedMs) / RESOLUTION_WINDOW;
+	if (d.samples < RESOLUTION_WINDOW) {
+		return d.scale;
+	}
+
+	if (d.smoothedMs > d.budgetMs || d.smoothedMs < RESOLUTION_LOW * d.budgetMs) {
+		GLfloat target = d.scale * GLfloat(sqrt(RESOLUTION_HEADROOM * d.budgetMs / d.smoothedMs));
+		target = floor(target / RESOLUTION_STEP + 1e-3f) * RESOLUTION_STEP;
+		target = std::min(std::max(target, d.minScale), d.maxScale);
+		if (fabs(target - d.scale) > 1e-3f) {
+			d.scale = target;
+			d.samples = -RESOLUTION_WINDOW;
+			d.changes++;
+		}
+	}
+	return d.scale;
+}
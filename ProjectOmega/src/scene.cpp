@@ -0,0 +1,795 @@
+#include <scene.h>
+#include <glextra.h>
+#include <glstate.h>
+#include <log.h>
+
+float skybox[] = {
+	// positions
+	-1.0f,  1.0f, -1.0f,
+	-1.0f, -1.0f, -1.0f,
+	 1.0f, -1.0f, -1.0f,
+	 1.0f, -1.0f, -1.0f,
+	 1.0f,  1.0f, -1.0f,
+	-1.0f,  1.0f, -1.0f,
+
+	-1.0f, -1.0f,  1.0f,
+	-1.0f, -1.0f, -1.0f,
+	-1.0f,  1.0f, -1.0f,
+	-1.0f,  1.0f, -1.0f,
+	-1.0f,  1.0f,  1.0f,
+	-1.0f, -1.0f,  1.0f,
+
+	 1.0f, -1.0f, -1.0f,
+	 1.0f, -1.0f,  1.0f,
+	 1.0f,  1.0f,  1.0f,
+	 1.0f,  1.0f,  1.0f,
+	 1.0f,  1.0f, -1.0f,
+	 1.0f, -1.0f, -1.0f,
+
+	-1.0f, -1.0f,  1.0f,
+	-1.0f,  1.0f,  1.0f,
+	 1.0f,  1.0f,  1.0f,
+	 1.0f,  1.0f,  1.0f,
+	 1.0f, -1.0f,  1.0f,
+	-1.0f, -1.0f,  1.0f,
+
+	-1.0f,  1.0f, -1.0f,
+	 1.0f,  1.0f, -1.0f,
+	 1.0f,  1.0f,  1.0f,
+	 1.0f,  1.0f,  1.0f,
+	-1.0f,  1.0f,  1.0f,
+	-1.0f,  1.0f, -1.0f,
+
+	-1.0f, -1.0f, -1.0f,
+	-1.0f, -1.0f,  1.0f,
+	 1.0f, -1.0f, -1.0f,
+	 1.0f, -1.0f, -1.0f,
+	-1.0f, -1.0f,  1.0f,
+	 1.0f, -1.0f,  1.0f
+};
+
+struct Vertexture {
+	GLfloat x, y, z, s, t;
+};
+
+Vertexture full_screens[] = {
+	{-1, 1, 0, 0, 1},
+	{-1, -1, 0, 0, 0},
+	{1, 1, 0, 1, 1},
+	{1, -1, 0, 1, 0}
+};
+
+std::vector<std::string> faces = { "textures/px.jpg", "textures/nx.jpg", "textures/py.jpg", "textures/ny.jpg", "textures/pz.jpg", "textures/nz.jpg" };
+
+void orbitCamera(GLfloat yaw, GLfloat pitch, glm::vec3 & front, glm::vec3 & pos) {
+	/*
+	Points the camera along yaw/pitch (degrees) and places it one unit back from the origin
+	*/
+	glm::vec3 dir;
+	dir.x = cos(glm::radians(pitch)) * cos(glm::radians(yaw));
+	dir.y = sin(glm::radians(pitch));
+	dir.z = cos(glm::radians(pitch)) * sin(glm::radians(yaw));
+	front = glm::normalize(dir);
+
+	pos = -front;
+}
+
+bool projectedRect(const glm::mat4 & mvp, glm::vec3 lo, glm::vec3 hi, GLsizei width, GLsizei height, GLint rect[4]) {
+	/*
+	Projects the 8 corners of the box and returns x, y, width, height of their bounding rectangle, grown by
+	a pixel on every side for the bilinear footprint of whoever samples it
+	*/
+	glm::vec2 ndcMin(1e9f), ndcMax(-1e9f);
+	for (int i = 0; i < 8; i++) {
+		glm::vec4 c = mvp * glm::vec4(i & 1 ? hi.x : lo.x, i & 2 ? hi.y : lo.y, i & 4 ? hi.z : lo.z, 1.f);
+		if (c.w <= 1e-5f) {
+			ndcMin = glm::vec2(-1.f);
+			ndcMax = glm::vec2(1.f);
+			break;
+		}
+		ndcMin = glm::min(ndcMin, glm::vec2(c) / c.w);
+		ndcMax = glm::max(ndcMax, glm::vec2(c) / c.w);
+	}
+	if (ndcMax.x < -1.f || ndcMax.y < -1.f || ndcMin.x > 1.f || ndcMin.y > 1.f) {
+		return false;
+	}
+
+	GLint x0 = glm::max(GLint(floor((ndcMin.x * .5f + .5f) * width)) - 1, 0);
+	GLint y0 = glm::max(GLint(floor((ndcMin.y * .5f + .5f) * height)) - 1, 0);
+	GLint x1 = glm::min(GLint(ceil((glm::min(ndcMax.x, 1.f) * .5f + .5f) * width)) + 1, GLint(width));
+	GLint y1 = glm::min(GLint(ceil((glm::min(ndcMax.y, 1.f) * .5f + .5f) * height)) + 1, GLint(height));
+	rect[0] = x0;
+	rect[1] = y0;
+	rect[2] = x1 - x0;
+	rect[3] = y1 - y0;
+	return rect[2] > 0 && rect[3] > 0;
+}
+
+bool initScene(Scene & s, GLsizei width, GLsizei height, GLfloat blurRadius, const std::string & profileOutput, int profileEvery) {
+	/*
+	Creates the geometry, render targets, textures and programs of the scene for a width x height output
+	Returns false if a framebuffer could not be completed
+	*/
+	s.width = width;
+	s.height = height;
+
+	// OpenGL stuff
+	{
+		glEnable(GL_DEPTH_TEST);										// enable depth test
+		glEnable(GL_CULL_FACE);											// enable face culling
+		glCullFace(GL_BACK);											// cull back-facing polygons (GL_BACK by default but calling anyway)
+		glEnable(GL_CLIP_DISTANCE0);
+	}
+
+	{
+		glGenVertexArrays(1, &s.skyboxVAO);
+		glGenBuffers(1, &s.skyboxVBO);
+		glBindVertexArray(s.skyboxVAO);
+		glBindBuffer(GL_ARRAY_BUFFER, s.skyboxVBO);
+		glBufferData(GL_ARRAY_BUFFER, sizeof(skybox), &skybox, GL_STATIC_DRAW);
+		glEnableVertexAttribArray(0);
+		glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 3 * sizeof(float), (void*)0);
+	}
+
+	s.sphere = genIndexedSphere(0.1125f, 50);
+	{
+		glGenVertexArrays(1, &s.sphereVAO);
+		glGenBuffers(1, &s.sphereVBO);
+		glBindVertexArray(s.sphereVAO);
+		glBindBuffer(GL_ARRAY_BUFFER, s.sphereVBO);
+
+		glBufferData(GL_ARRAY_BUFFER, s.sphere.vertices.size() * sizeof(Vertex), s.sphere.vertices.data(), GL_STATIC_DRAW);
+		glGenBuffers(1, &s.sphereEBO);
+		glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, s.sphereEBO);
+		s.sphere.indexType = uploadIndices(s.sphere.indices, s.sphere.vertices.size());
+		glEnableVertexAttribArray(0);
+		glEnableVertexAttribArray(1);
+		glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, sizeof(Vertex), 0);
+		glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*)offsetof(Vertex, x1));
+	}
+
+	s.cube = genIndexedCube(0.5f, 50);
+	{
+		glGenVertexArrays(1, &s.cubeVAO);
+		glBindVertexArray(s.cubeVAO);
+		glGenBuffers(1, &s.cubeVBO);
+		glBindBuffer(GL_ARRAY_BUFFER, s.cubeVBO);
+		glBindVertexArray(s.cubeVAO);
+
+		glBufferData(GL_ARRAY_BUFFER, s.cube.vertices.size() * sizeof(Vertex), s.cube.vertices.data(), GL_STATIC_DRAW);
+		glGenBuffers(1, &s.cubeEBO);
+		glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, s.cubeEBO);
+		s.cube.indexType = uploadIndices(s.cube.indices, s.cube.vertices.size());
+		glEnableVertexAttribArray(0);
+		glEnableVertexAttribArray(1);
+		glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, sizeof(Vertex), 0);
+		glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*)offsetof(Vertex, x1));
+	}
+
+	s.texcube = genIndexedTexCube(0.5f, 1);
+	//auto texcube = genTexPlane(glm::vec3(0, 1, 0), glm::vec3(1, 0, 0), glm::vec3(-1, -1, 0), 1);
+	{
+		glGenVertexArrays(1, &s.cubeTexVAO);
+		glBindVertexArray(s.cubeTexVAO);
+		glGenBuffers(1, &s.cubeTexVBO);
+		glBindBuffer(GL_ARRAY_BUFFER, s.cubeTexVBO);
+		glBindVertexArray(s.cubeTexVAO);
+
+		glBufferData(GL_ARRAY_BUFFER, s.texcube.vertices.size() * sizeof(NewVertex), s.texcube.vertices.data(), GL_STATIC_DRAW);
+		glGenBuffers(1, &s.cubeTexEBO);
+		glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, s.cubeTexEBO);
+		s.texcube.indexType = uploadIndices(s.texcube.indices, s.texcube.vertices.size());
+		glEnableVertexAttribArray(0);
+		glEnableVertexAttribArray(1);
+		glEnableVertexAttribArray(2);
+		glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, sizeof(NewVertex), 0);
+		glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, sizeof(NewVertex), (void*)offsetof(NewVertex, x1));
+		glVertexAttribPointer(2, 2, GL_FLOAT, GL_FALSE, sizeof(NewVertex), (void*)offsetof(NewVertex, u));
+	}
+
+	s.plane = genIndexedPlane(glm::vec3(.2, .4, .3), glm::vec3(.3, .4, .2), glm::vec3(0, -.5, 0), 100);
+	{
+		glGenVertexArrays(1, &s.planeVAO);
+		glBindVertexArray(s.planeVAO);
+		glGenBuffers(1, &s.planeVBO);
+		glBindBuffer(GL_ARRAY_BUFFER, s.planeVBO);
+		glBindVertexArray(s.planeVAO);
+
+		glBufferData(GL_ARRAY_BUFFER, s.plane.vertices.size() * sizeof(Vertex), s.plane.vertices.data(), GL_STATIC_DRAW);
+		glGenBuffers(1, &s.planeEBO);
+		glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, s.planeEBO);
+		s.plane.indexType = uploadIndices(s.plane.indices, s.plane.vertices.size());
+		glEnableVertexAttribArray(0);
+		glEnableVertexAttribArray(1);
+		glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, sizeof(Vertex), 0);
+		glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*)offsetof(Vertex, x1));
+	}
+
+	//auto plane = genPlane(glm::vec3(.2, .4, .3), glm::vec3(.3, .4, .2), glm::vec3(0, -.5, 0), 100);
+	s.waterOrigin = glm::vec3(-.25f, 0.2, -.25f);
+	s.waterU = glm::vec3(0, 0, .5);
+	s.waterV = glm::vec3(.5, 0, 0);
+	s.waterMin = glm::min(glm::min(s.waterOrigin, s.waterOrigin + s.waterU), glm::min(s.waterOrigin + s.waterV, s.waterOrigin + s.waterU + s.waterV));
+	s.waterMax = glm::max(glm::max(s.waterOrigin, s.waterOrigin + s.waterU), glm::max(s.waterOrigin + s.waterV, s.waterOrigin + s.waterU + s.waterV));
+	glGenVertexArrays(1, &s.waterGridVAO);
+	setupWaterLod(s.lod);
+	s.waterLod = glExtras.tessellation ? WATER_LOD_TESS : WATER_LOD_QUADTREE;
+	logMessage(LOG_INFO, "Water: %s, vertices at most %g pixels apart", s.waterLod == WATER_LOD_TESS ? "tessellated" : "quadtree (no GL 4.0 tessellation)",
+		s.waterLodPixels);
+	setupWaterSim(s.sim, WATER_SIM_SIZE, glm::vec2(s.waterMin.x, s.waterMin.z), glm::vec2(s.waterMax.x - s.waterMin.x, s.waterMax.z - s.waterMin.z));
+	s.waterFloat = addWaterObject(s.sim, WATER_FLOAT_RADIUS, WATER_FLOAT_DEPTH);
+	logMessage(LOG_INFO, "Water simulation: %dx%d heightfield, %g steps/s", s.sim.size, s.sim.size, s.sim.rate);
+	setupWorkerPool(s.workers);
+	setupOcean(s.ocean, OCEAN_SIZE, s.sim.extent.x, false);
+	logMessage(LOG_INFO, "Ocean: %dx%d FFT on %zu worker threads and the render thread", s.ocean.size, s.ocean.size, s.workers.threads.size());
+	// onto the floor of the pool cube below the water
+	setupCaustics(s.caustics, CAUSTICS_SIZE, glm::vec4(s.waterMin.x, s.waterMin.z, s.waterMax.x - s.waterMin.x, s.waterMax.z - s.waterMin.z),
+		-.25f);
+	s.sunlight = glm::normalize(glm::vec3(.1f, -1.f, .05f));
+	logMessage(LOG_INFO, "Caustics: %ux%u light grid into %dx%d texels", s.caustics.grid, s.caustics.grid, s.caustics.size, s.caustics.size);
+
+	{
+		glGenVertexArrays(1, &s.screenVAO);
+		glBindVertexArray(s.screenVAO);
+		glGenBuffers(1, &s.screenVBO);
+		glBindBuffer(GL_ARRAY_BUFFER, s.screenVBO);
+		glBindVertexArray(s.screenVAO);
+
+		glBufferData(GL_ARRAY_BUFFER, sizeof(full_screens), full_screens, GL_STATIC_DRAW);
+		glEnableVertexAttribArray(0);
+		glEnableVertexAttribArray(1);
+		glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, sizeof(Vertexture), (void*)0);
+		glVertexAttribPointer(1, 2, GL_FLOAT, GL_FALSE, sizeof(Vertexture), (void*)offsetof(Vertexture, s));
+
+	}
+
+	// the frame graph's targets and the downsampled blur pyramid
+	s.blurScale = blurRadius / width;
+	if (!resizeScene(s, width, height, 1.f)) {
+		return false;
+	}
+	logMessage(LOG_INFO, "Blur pyramid: sigma %gpx, %d levels, %d taps, %g fetches/pixel (legacy %d), %s path", s.pyramid.radius, s.pyramid.levels,
+		s.pyramid.taps, blurPyramidFetches(s.pyramid), 9 * BLUR_PASSES, blurPyramidCompute(s.pyramid) ? "compute" : "fragment");
+
+	///loading programs
+
+	//skybox
+	loadTextures({
+		{ &s.sbox, 0, GL_TEXTURE_CUBE_MAP, faces },
+		{ &s.dudvmap, 6, GL_TEXTURE_2D, { "textures/dudv.jpg" } },
+		{ &s.pooltex, 7, GL_TEXTURE_2D, { "textures/bathroom_tiles.jpg" } },
+	});
+
+	//SB program
+	s.skyboxprogram = loadProgram("shaders/skybox.vsh", "shaders/skybox.fsh");
+	s.s_cube = glGetUniformLocation(s.skyboxprogram, "skybox");
+	bindUniformBlocks(s.skyboxprogram);
+
+	glUseProgram(s.skyboxprogram);
+	glUniform1i(s.s_cube, 0);
+
+	//render programs (the water and combine variants are built by waterProgram / combineProgram when first drawn)
+	s.transprogram = loadProgram("shaders/refract.vsh", "shaders/refract.fsh");
+	{
+		s.t_cube = glGetUniformLocation(s.transprogram, "skybox");
+		s.t_pooltex = glGetUniformLocation(s.transprogram, "pooltex");
+		bindUniformBlocks(s.transprogram);
+	}
+
+
+	//blur program
+	s.frameprogram = loadProgram("shaders/frame.vsh", "shaders/frame.fsh");
+	s.f_frametex = glGetUniformLocation(s.frameprogram, "frametex"); //source texture for blurring
+	s.f_offset = glGetUniformLocation(s.frameprogram, "offset"); //tap distance in texture coordinates
+
+	glUseProgram(s.frameprogram);
+	glUniform1i(s.f_frametex, 3);
+
+	s.poolprogram = loadProgram("shaders/plain.vsh", "shaders/plain.fsh");
+	{
+		s.p_pool_tex = glGetUniformLocation(s.poolprogram, "poolTexture");
+		bindUniformBlocks(s.poolprogram);
+
+		s.p_caustics = glGetUniformLocation(s.poolprogram, "caustics");
+	}
+
+	glUseProgram(s.poolprogram);
+	glUniform1i(s.p_pool_tex, 7);
+	glUniform1i(s.p_caustics, CAUSTICS_UNIT);
+	glUniform4fv(glGetUniformLocation(s.poolprogram, "caustics_rect"), 1, &s.caustics.rect.x);
+	glUniform1f(glGetUniformLocation(s.poolprogram, "water_level"), s.waterOrigin.y);
+
+	logMessage(LOG_INFO, "Programs: %d (%d from %s) in %g ms", shaderCacheStats.hits + shaderCacheStats.misses, shaderCacheStats.hits,
+		glExtras.programBinary ? SHADER_CACHE_DIR : "no binary cache", shaderCacheStats.ms);
+
+	s.lightpos = glm::vec3(-0.3, 0.7, -0.2);
+	s.lightcol = glm::vec3(1, 1, 1);
+
+	setupUniformRing(s.uniforms);
+	setupFramePacer(s.pacer);
+	setupAutofocus(s.autofocus);
+
+	// per-pass timers, named after the blocks of the render loop
+	setupProfiler(s.profiler, profileOutput, profileEvery);
+	s.pass_watersim = profilerPass(s.profiler, "water sim");
+	s.pass_ocean = profilerPass(s.profiler, "ocean");
+	s.pass_caustics = profilerPass(s.profiler, "caustics");
+	s.pass_refract = profilerPass(s.profiler, "refractFbo");
+	s.pass_water = profilerPass(s.profiler, "water plane");
+	s.pass_pool = profilerPass(s.profiler, "pool");
+	s.pass_skybox = profilerPass(s.profiler, "skybox");
+	s.pass_blur = profilerPass(s.profiler, "blur");
+	s.pass_legacyBlur = profilerPass(s.profiler, "legacy blur");
+	s.pass_autofocus = profilerPass(s.profiler, "autofocus");
+	s.pass_dof = profilerPass(s.profiler, "dof");
+	s.pass_combine = profilerPass(s.profiler, "combine");
+
+	invalidateGLState();
+	return true;
+}
+
+bool resizeScene(Scene & s, GLsizei width, GLsizei height, GLfloat renderScale) {
+	/*
+	Gives every offscreen target renderScale times the output size, and the refraction refractScale times
+	that, by rebuilding the frame graph; the blur pyramid and depth of field reallocate theirs. Does nothing
+	if the render size stays the same
+	*/
+	GLsizei w = glm::max(GLsizei(width * renderScale + .5f), 1), h = glm::max(GLsizei(height * renderScale + .5f), 1);
+	bool output = width != s.width || height != s.height;
+	s.width = width;
+	s.height = height;
+	s.renderScale = renderScale;
+	if (w == s.renderWidth && h == s.renderHeight) {
+		return !output || buildFrameGraph(s, s.graphParams, s.graphTarget);
+	}
+	s.renderWidth = w;
+	s.renderHeight = h;
+	s.refractWidth = glm::max(GLsizei(w * s.refractScale + .5f), 1);
+	s.refractHeight = glm::max(GLsizei(h * s.refractScale + .5f), 1);
+
+	setupBlurPyramid(s.pyramid, w, h, s.blurScale * w);
+	setupDepthOfField(s.dof, w, h, FOV_Y);
+	invalidateGLState();
+	return buildFrameGraph(s, s.graphParams, s.graphTarget);
+}
+
+static bool sameSwitches(const FrameParams & a, const FrameParams & b) {
+	return a.selection == b.selection && a.blurDof == b.blurDof && a.autofocus == b.autofocus
+		&& a.legacyBlur == b.legacyBlur && a.measureBlur == b.measureBlur
+		&& (a.style % WATER_STYLES == WATER_SIM_STYLE) == (b.style % WATER_STYLES == WATER_SIM_STYLE)
+		&& (a.style % WATER_STYLES == WATER_OCEAN_STYLE) == (b.style % WATER_STYLES == WATER_OCEAN_STYLE);
+}
+
+static void setupWaterMesh(Scene & s) {
+	/*
+	Vertex and index buffers of the water plane, for when the bufferless grid is off
+	*/
+	s.newPlane = genIndexedTexPlane(s.waterU, s.waterV, s.waterOrigin, WATER_RESOLUTION);
+	glGenVertexArrays(1, &s.newPlaneVAO);
+	glBindVertexArray(s.newPlaneVAO);
+	glGenBuffers(1, &s.newPlaneVBO);
+	glBindBuffer(GL_ARRAY_BUFFER, s.newPlaneVBO);
+	glBufferData(GL_ARRAY_BUFFER, s.newPlane.vertices.size() * sizeof(NewVertex), s.newPlane.vertices.data(), GL_STATIC_DRAW);
+	glGenBuffers(1, &s.newPlaneEBO);
+	glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, s.newPlaneEBO);
+	s.newPlane.indexType = uploadIndices(s.newPlane.indices, s.newPlane.vertices.size());
+	glEnableVertexAttribArray(0);
+	glEnableVertexAttribArray(1);
+	glEnableVertexAttribArray(2);
+	glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, sizeof(NewVertex), 0);
+	glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, sizeof(NewVertex), (void*)offsetof(NewVertex, x1));
+	glVertexAttribPointer(2, 2, GL_FLOAT, GL_FALSE, sizeof(NewVertex), (void*)offsetof(NewVertex, u));
+	invalidateGLState();
+
+	CacheStats c = cacheStats(s.newPlane.indices, s.newPlane.vertices.size());
+	logMessage(LOG_INFO, "Water plane: %zu vertices, %zu triangles, ACMR %g, ATVR %g", s.newPlane.vertices.size(), s.newPlane.indices.size() / 3,
+		c.acmr, c.atvr);
+}
+
+static void waterStyleUniforms(Scene & s, GLuint program, int style) {
+	/*
+	Points a program including water.glsl at the textures of the styles that displace the water by one
+	*/
+	if (style == WATER_SIM_STYLE || style == WATER_OCEAN_STYLE) {
+		glUniform1i(glGetUniformLocation(program, "heightfield"), WATER_SIM_UNIT);
+		glUniform1i(glGetUniformLocation(program, "displacement"), OCEAN_UNIT);
+		glUniform1i(glGetUniformLocation(program, "normals"), OCEAN_UNIT + 1);
+		glUniform4f(glGetUniformLocation(program, "heightfield_rect"), s.sim.origin.x, s.sim.origin.y, s.sim.extent.x, s.sim.extent.y);
+	}
+}
+
+static GLuint waterProgram(Scene & s, int style, bool grid) {
+	/*
+	reflect.vsh / reflect.fsh specialized for one water style, reading the mesh or generating the grid the
+	way waterLod asks: uniform, tessellated (watertess.*) or the quadtree's nodes
+	*/
+	GLuint & program = grid ? s.gridprograms[s.waterLod][style] : s.sphereprograms[style];
+	if (!program) {
+		std::string defines = "STYLE " + std::to_string(style);
+		if (grid && s.waterLod == WATER_LOD_TESS) {
+			program = loadTessProgram("shaders/watertess.vsh", "shaders/watertess.tcs", "shaders/watertess.tes", "shaders/reflect.fsh", { defines });
+		}
+		else {
+			int variant = !grid ? 0 : s.waterLod == WATER_LOD_QUADTREE ? 2 : 1;
+			program = loadProgram("shaders/reflect.vsh", "shaders/reflect.fsh", { defines, "WATER_GRID " + std::to_string(variant) });
+		}
+		s.u_cube = glGetUniformLocation(program, "skybox");
+		s.u_dudv = glGetUniformLocation(program, "dudv");
+		s.u_pooltex = glGetUniformLocation(program, "pooltex");
+		s.u_poolnorm = glGetUniformLocation(program, "poolnorm");
+		bindUniformBlocks(program);
+
+		useProgram(program);
+		glUniform1i(s.u_pooltex, 8);
+		waterStyleUniforms(s, program, style);
+	}
+	return program;
+}
+
+static GLuint causticsProgram(Scene & s, int style) {
+	/*
+	caustics.vsh / caustics.fsh specialized for one water style, the same surface as waterProgram's
+	*/
+	GLuint & program = s.causticsprograms[style];
+	if (!program) {
+		program = loadProgram("shaders/caustics.vsh", "shaders/caustics.fsh", { "STYLE " + std::to_string(style) });
+		bindUniformBlocks(program);
+
+		useProgram(program);
+		waterStyleUniforms(s, program, style);
+		glUniform3fv(glGetUniformLocation(program, "light"), 1, &s.sunlight.x);
+		glUniform4fv(glGetUniformLocation(program, "floor_rect"), 1, &s.caustics.rect.x);
+		glUniform1f(glGetUniformLocation(program, "floor_height"), s.caustics.floor);
+	}
+	return program;
+}
+
+static GLuint combineProgram(Scene & s, int selection) {
+	/*
+	combine.fsh specialized for one output, it only samples the texture that output shows
+	*/
+	GLuint & program = s.combineprograms[selection - 1];
+	if (!program) {
+		program = loadProgram("shaders/frame.vsh", "shaders/combine.fsh", { "SELECTION " + std::to_string(selection) });
+		s.c_pristineTex = glGetUniformLocation(program, "pristineTex");
+		s.c_dofTex = glGetUniformLocation(program, "dofTex");
+
+		useProgram(program);
+		glUniform1i(s.c_pristineTex, 3);
+		glUniform1i(s.c_dofTex, 4);
+	}
+	return program;
+}
+
+bool buildFrameGraph(Scene & s, const FrameParams & f, GLuint targetFbo) {
+	/*
+	Declares every pass the scene has; the switches only decide what the depth of field and the combine
+	pass read, and compileFrameGraph culls whatever that leaves unused
+	*/
+	s.graphParams = f;
+	s.graphTarget = targetFbo;
+	FrameGraph & g = s.graph;
+	resetFrameGraph(g);
+
+	FrameTextureDesc color, depth, refract, refractDepth;
+	color.width = depth.width = s.renderWidth;
+	color.height = depth.height = s.renderHeight;
+	depth.internalFormat = GL_DEPTH_COMPONENT24;
+	refract.width = refractDepth.width = s.refractWidth;
+	refract.height = refractDepth.height = s.refractHeight;
+	refractDepth.internalFormat = GL_DEPTH_COMPONENT24;
+	refractDepth.filter = GL_NEAREST;
+
+	s.r_heightfield = importFrameTexture(g, "heightfield", s.sim.output);
+	s.r_ocean = importFrameTexture(g, "ocean", s.ocean.displacement);
+	s.r_caustics = importFrameTexture(g, "caustics", s.caustics.texture);
+	s.r_refract = addFrameTexture(g, "refraction", refract);
+	s.r_refractDepth = addFrameTexture(g, "refraction depth", refractDepth);
+	s.r_color = addFrameTexture(g, "color", color);
+	s.r_depth = addFrameTexture(g, "depth", depth);
+	s.r_blur[0] = addFrameTexture(g, "legacy blur 0", color);
+	s.r_blur[1] = addFrameTexture(g, "legacy blur 1", color);
+	s.r_pyramid = importFrameTexture(g, "blur pyramid", s.pyramid.output);
+	s.r_focus = importFrameTexture(g, "focus", s.autofocus.output);
+	s.r_dof = importFrameTexture(g, "depth of field", s.dof.output);
+	s.r_output = importFramebuffer(g, "output", targetFbo, s.width, s.height);
+	int legacy = s.r_blur[(BLUR_PASSES + 1) % 2];
+	int blurred = f.legacyBlur ? legacy : s.r_pyramid;
+	bool simulated = f.style % WATER_STYLES == WATER_SIM_STYLE, ocean = f.style % WATER_STYLES == WATER_OCEAN_STYLE;
+
+	// catches the water simulation up with the frame's time, culled unless the water shows it
+	addFramePass(g, "water simulation", {}, { s.r_heightfield }, [&s]() {
+		runWaterSim(s.sim, s.params.time, s.screenVAO);
+	}).profile = s.pass_watersim;
+
+	addFramePass(g, "ocean", {}, { s.r_ocean }, [&s]() {
+		runOcean(s.ocean, s.workers, s.params.time, s.screenVAO);
+	}).profile = s.pass_ocean;
+
+	// the light through the same surface as the water draw, onto the floor the pool passes draw
+	std::vector<int> waterReads;
+	if (simulated) waterReads.push_back(s.r_heightfield);
+	if (ocean) waterReads.push_back(s.r_ocean);
+	addFramePass(g, "caustics", waterReads, { s.r_caustics }, [&s]() {
+		int style = s.params.style % WATER_STYLES;
+		useProgram(causticsProgram(s, style));
+		glBindBufferRange(GL_UNIFORM_BUFFER, PER_DRAW_BINDING, s.uniforms.buffer, s.waterOffset, sizeof(PerDraw));
+		glBindBufferRange(GL_UNIFORM_BUFFER, WATER_GRID_BINDING, s.uniforms.buffer, s.causticsGridOffset, sizeof(WaterGrid));
+		if (style == WATER_SIM_STYLE) {
+			bindTexture(WATER_SIM_UNIT, GL_TEXTURE_2D, s.sim.output);
+		}
+		else if (style == WATER_OCEAN_STYLE) {
+			bindTexture(OCEAN_UNIT, GL_TEXTURE_2D, s.ocean.displacement);
+			bindTexture(OCEAN_UNIT + 1, GL_TEXTURE_2D, s.ocean.normals);
+		}
+		runCaustics(s.caustics, s.waterGridVAO);
+	}).profile = s.pass_caustics;
+
+	// the pool under the water, only where the water will sample it (every draw sets the state it depends
+	// on, glState drops what is already set)
+	{
+		FramePass & p = addFramePass(g, "refraction", { s.r_caustics }, {}, [&s]() {
+			GLint rect[4] = { 0, 0, s.refractWidth, s.refractHeight };
+			bool visible = !s.refractCull || projectedRect(s.perFrame.projection * s.perFrame.view, s.waterMin, s.waterMax,
+				s.refractWidth, s.refractHeight, rect);
+			if (!visible) {
+				return;
+			}
+			// the clear is scissored too, so it is left to the pass
+			setCapability(GL_SCISSOR_TEST, true);
+			glScissor(rect[0], rect[1], rect[2], rect[3]);
+			glClearColor(0.1f, 0.3f, 0.5f, 1.0f);
+			setCapability(GL_DEPTH_TEST, true);
+			glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+
+			setCapability(GL_CULL_FACE, true);
+			setFrontFace(GL_CW);
+			setDepthFunc(GL_LESS);
+			useProgram(s.poolprogram);
+			glBindBufferRange(GL_UNIFORM_BUFFER, PER_DRAW_BINDING, s.uniforms.buffer, s.refractPoolOffset, sizeof(PerDraw));
+			bindTexture(CAUSTICS_UNIT, GL_TEXTURE_2D, s.caustics.texture);
+			bindVertexArray(s.cubeTexVAO);
+			glDrawElements(GL_TRIANGLES, s.texcube.indices.size(), s.texcube.indexType, 0);
+			setCapability(GL_SCISSOR_TEST, false);
+		});
+		p.color = s.r_refract;
+		p.depth = s.r_refractDepth;
+		p.profile = s.pass_refract;
+	}
+
+	// water, pool and skybox
+	{
+		std::vector<int> reads = waterReads;
+		reads.push_back(s.r_refract);
+		reads.push_back(s.r_caustics);
+		FramePass & p = addFramePass(g, "scene", reads, {}, [&s]() {
+			setCapability(GL_DEPTH_TEST, true);
+
+			// water plane
+			{
+				ProfileScope scope(s.profiler, s.pass_water);
+				setCapability(GL_CULL_FACE, false);
+				setDepthFunc(GL_LESS);
+				int style = s.params.style % WATER_STYLES;
+				useProgram(waterProgram(s, style, s.waterGrid));
+				glBindBufferRange(GL_UNIFORM_BUFFER, PER_DRAW_BINDING, s.uniforms.buffer, s.waterOffset, sizeof(PerDraw));
+				bindTexture(0, GL_TEXTURE_CUBE_MAP, s.sbox);
+				bindTexture(8, GL_TEXTURE_2D, frameTexture(s.graph, s.r_refract));
+				if (style == WATER_SIM_STYLE) {
+					bindTexture(WATER_SIM_UNIT, GL_TEXTURE_2D, s.sim.output);
+				}
+				else if (style == WATER_OCEAN_STYLE) {
+					bindTexture(OCEAN_UNIT, GL_TEXTURE_2D, s.ocean.displacement);
+					bindTexture(OCEAN_UNIT + 1, GL_TEXTURE_2D, s.ocean.normals);
+				}
+				if (s.waterQuery) {
+					glBeginQuery(GL_PRIMITIVES_GENERATED, s.waterQuery);
+				}
+				if (s.waterGrid) {
+					glBindBufferRange(GL_UNIFORM_BUFFER, WATER_GRID_BINDING, s.uniforms.buffer, s.waterGridOffset, sizeof(WaterGrid));
+					if (s.waterLod == WATER_LOD_TESS) {
+						// a patch of four corners per quad of the coarse grid
+						bindVertexArray(s.waterGridVAO);
+						glPatchParameteri(GL_PATCH_VERTICES, 4);
+						glDrawArrays(GL_PATCHES, 0, 4 * WATER_TESS_PATCHES * WATER_TESS_PATCHES);
+					}
+					else if (s.waterLod == WATER_LOD_QUADTREE) {
+						drawWaterLod(s.lod);
+					}
+					else {
+						// a triangle strip per row of quads
+						bindVertexArray(s.waterGridVAO);
+						glDrawArraysInstanced(GL_TRIANGLE_STRIP, 0, 2 * (s.waterResolution + 1), s.waterResolution);
+					}
+				}
+				else {
+					bindVertexArray(s.newPlaneVAO);
+					glDrawElements(GL_TRIANGLES, s.newPlane.indices.size(), s.newPlane.indexType, 0);
+				}
+				if (s.waterQuery) {
+					glEndQuery(GL_PRIMITIVES_GENERATED);
+				}
+			}
+
+			// pool
+			{
+				ProfileScope scope(s.profiler, s.pass_pool);
+				setCapability(GL_CULL_FACE, true);
+				setFrontFace(GL_CW);
+				useProgram(s.poolprogram);
+				glBindBufferRange(GL_UNIFORM_BUFFER, PER_DRAW_BINDING, s.uniforms.buffer, s.poolOffset, sizeof(PerDraw));
+				bindTexture(CAUSTICS_UNIT, GL_TEXTURE_2D, s.caustics.texture);
+
+				bindVertexArray(s.cubeTexVAO);
+				glDrawElements(GL_TRIANGLES, s.texcube.indices.size(), s.texcube.indexType, 0);
+			}
+
+			//skybox
+			{
+				ProfileScope scope(s.profiler, s.pass_skybox);
+				setCapability(GL_CULL_FACE, true);
+				setFrontFace(GL_CCW);
+				setDepthFunc(GL_LEQUAL);
+				useProgram(s.skyboxprogram);
+
+				bindVertexArray(s.skyboxVAO);
+				glDrawArrays(GL_TRIANGLES, 0, 36);
+			}
+			setCapability(GL_DEPTH_TEST, false);
+		});
+		p.color = s.r_color;
+		p.depth = s.r_depth;
+		p.clear = GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT;
+		p.clearColor = glm::vec4(0.1f, 0.3f, 0.5f, 1.0f);
+	}
+
+	// the old full-resolution blur, ping-ponging between its two targets
+	addFramePass(g, "legacy blur", { s.r_color }, { s.r_blur[0], s.r_blur[1] }, [&s]() {
+		bindFramebuffer(frameFramebuffer(s.graph, s.r_blur[0]));
+		setViewport(0, 0, s.renderWidth, s.renderHeight);
+		bindTexture(3, GL_TEXTURE_2D, frameTexture(s.graph, s.r_color));
+
+		bindVertexArray(s.screenVAO);
+		useProgram(s.frameprogram);
+		// a fixed fraction of the width, the same number of texels in both directions
+		glUniform2f(s.f_offset, LEGACY_BLUR_OFFSET, LEGACY_BLUR_OFFSET * s.renderWidth / s.renderHeight);
+
+		glDrawArrays(GL_TRIANGLE_STRIP, 0, 4);
+
+		for (int i = 1; i < BLUR_PASSES; i++) {
+			bindFramebuffer(frameFramebuffer(s.graph, s.r_blur[i % 2]));
+			bindTexture(3, GL_TEXTURE_2D, frameTexture(s.graph, s.r_blur[(i + 1) % 2]));
+			glDrawArrays(GL_TRIANGLE_STRIP, 0, 4);
+		}
+	}).profile = s.pass_legacyBlur;
+
+	addFramePass(g, "blur pyramid", { s.r_color }, { s.r_pyramid }, [&s]() {
+		runBlurPyramid(s.pyramid, frameTexture(s.graph, s.r_color), s.screenVAO);
+	}).profile = s.pass_blur;
+
+	// only for the one frame that asks for it; both blurs run in it, each under its own timer
+	addFramePass(g, "measure blur", { s.r_pyramid, legacy }, {}, [&s, legacy]() {
+		BlurError e = measureBlurError(s.pyramid, frameTexture(s.graph, legacy));
+		logMessage(LOG_INFO, "Blur pyramid vs legacy: mean %g, max %g (8-bit steps)", e.mean, e.max);
+	}).sideEffect = f.measureBlur;
+
+	//depth of field, focused by the GPU itself if autofocus is on
+	addFramePass(g, "autofocus", { s.r_depth }, { s.r_focus }, [&s]() {
+		runAutofocus(s.autofocus, frameTexture(s.graph, s.r_depth), s.params.time, s.screenVAO);
+	}).profile = s.pass_autofocus;
+
+	std::vector<int> dofReads = { s.r_color, s.r_depth };
+	if (f.blurDof) dofReads.push_back(blurred);
+	if (f.autofocus) dofReads.push_back(s.r_focus);
+	addFramePass(g, "depth of field", dofReads, { s.r_dof }, [&s, blurred]() {
+		const FrameParams & f = s.params;
+		runDepthOfField(s.dof, frameTexture(s.graph, s.r_color), frameTexture(s.graph, s.r_depth),
+			f.blurDof ? frameTexture(s.graph, blurred) : 0, f.autofocus ? s.autofocus.output : 0, s.screenVAO);
+	}).profile = s.pass_dof;
+
+	//combine, reading only what the selected output shows
+	int selection = glm::clamp(f.selection, 1, COMBINE_OUTPUTS);
+	{
+		FramePass & p = addFramePass(g, "combine", { selection <= 2 ? s.r_color : s.r_dof }, {}, [&s, selection]() {
+			bindTexture(3, GL_TEXTURE_2D, frameTexture(s.graph, s.r_color));
+			bindTexture(4, GL_TEXTURE_2D, s.dof.output);
+			bindVertexArray(s.screenVAO);
+			useProgram(combineProgram(s, selection));
+			glDrawArrays(GL_TRIANGLE_STRIP, 0, 4);
+		});
+		p.color = s.r_output;
+		p.clear = GL_COLOR_BUFFER_BIT;
+		p.clearColor = glm::vec4(0.1f, 0.3f, 0.5f, 1.0f);
+		p.profile = s.pass_combine;
+	}
+
+	return compileFrameGraph(g);
+}
+
+void renderScene(Scene & s, const FrameParams & f, GLuint targetFbo) {
+	/*
+	Renders one frame and writes the combined result to targetFbo (0 for the window)
+	Waits for the next frame context first, so at most s.pacer.frames frames are queued on the GPU
+	*/
+	if (!sameSwitches(f, s.graphParams) || targetFbo != s.graphTarget) {
+		buildFrameGraph(s, f, targetFbo);
+	}
+	if (!s.waterGrid && !s.newPlaneVAO) {
+		setupWaterMesh(s);
+	}
+	if (f.style % WATER_STYLES == WATER_SIM_STYLE) {
+		// a float circling the pool and a drop every WATER_RAIN seconds, both from the clock so the bench repeats
+		glm::vec2 center = glm::vec2(s.waterMin.x + s.waterMax.x, s.waterMin.z + s.waterMax.z) * .5f;
+		moveWaterObject(s.sim, s.waterFloat, center + .15f * glm::vec2(cos(.8f * f.time), sin(.8f * f.time)));
+		int rain = int(f.time / WATER_RAIN);
+		s.rainDrops = glm::min(s.rainDrops, rain);
+		for (; s.rainDrops < rain; s.rainDrops++) {
+			glm::vec2 at = glm::fract(sin(GLfloat(s.rainDrops) * glm::vec2(12.9898f, 78.233f)) * 43758.5453f);
+			addWaterDrop(s.sim, s.sim.origin + at * s.sim.extent, WATER_DROP_RADIUS, WATER_DROP_HEIGHT);
+		}
+	}
+	int context = beginFrame(s.pacer);
+	profilerFrameBegin(s.profiler);
+
+	// every uniform block of the frame goes into the ring up front, the draws only bind their range
+	PerFrame & frame = s.perFrame;
+	frame = {};
+	frame.view = glm::lookAt(f.cameraPos, f.cameraPos + f.cameraFront, f.cameraUp);
+	frame.projection = glm::perspective(glm::radians(FOV_Y), (float)s.width / s.height, .1f, 100.f);
+	frame.eyePos = f.cameraPos;
+	frame.time = f.time;
+	frame.lightPos = f.cameraPos;
+	frame.focus = 1.f + .4f * sin(.75f * f.time);		// sweeps from the near to the far side of the pool
+	frame.lightColor = s.lightcol;
+	s.params = f;
+
+	PerDraw refractPool = {}, water = {}, pool = {};
+	refractPool.model = glm::mat4(1.f);
+	refractPool.clipPlane = glm::vec4(0, -1, 0, .2);
+	water.model = glm::mat4(1.f);		// the refraction pass culls against the water bounds untransformed
+	// water.model = glm::scale(water.model, glm::vec3(1.f, 0.8f, 1.f));
+	// water.model = glm::rotate(water.model, 90.f * PI / 180.f, glm::vec3(1.f, 0.f, 0.f));
+	pool.model = glm::mat4(1.f);
+
+	uniformRingBegin(s.uniforms, context);
+	GLintptr frameOffset = uniformRingWrite(s.uniforms, &frame, sizeof(frame));
+	s.refractPoolOffset = uniformRingWrite(s.uniforms, &refractPool, sizeof(PerDraw));
+	s.waterOffset = uniformRingWrite(s.uniforms, &water, sizeof(PerDraw));
+	s.poolOffset = uniformRingWrite(s.uniforms, &pool, sizeof(PerDraw));
+	if (s.waterGrid) {
+		if (s.waterLod == WATER_LOD_TESS && !glExtras.tessellation) {
+			s.waterLod = WATER_LOD_QUADTREE;
+		}
+		WaterGrid grid = {};
+		grid.origin = s.waterOrigin;
+		s.waterResolution = glm::clamp(s.waterResolution, 1u, GLuint(WATER_RESOLUTION_MAX));
+		grid.resolution = s.waterLod == WATER_LOD_TESS ? WATER_TESS_PATCHES : s.waterLod == WATER_LOD_QUADTREE ? WATER_LOD_NODE : GLint(s.waterResolution);
+		grid.u = s.waterU;
+		grid.v = s.waterV;
+		// pixels per radian of the render target over the spacing allowed
+		grid.lod = s.renderHeight / (2.f * tan(glm::radians(FOV_Y) * .5f)) / s.waterLodPixels;
+		grid.morph = WATER_LOD_MORPH;
+		s.waterGridOffset = uniformRingWrite(s.uniforms, &grid, sizeof(grid));
+		if (s.waterLod == WATER_LOD_QUADTREE) {
+			selectWaterLod(s.lod, f.cameraPos, s.waterOrigin, s.waterU, s.waterV, grid.lod);
+			uploadWaterLod(s.lod, context);
+		}
+	}
+	{
+		// the caustics' grid spans the water too, at its own resolution whatever the water's tessellation
+		WaterGrid grid = {};
+		grid.origin = s.waterOrigin;
+		s.caustics.grid = glm::clamp(s.caustics.grid, 1u, GLuint(CAUSTICS_GRID_MAX));
+		grid.resolution = GLint(s.caustics.grid);
+		grid.u = s.waterU;
+		grid.v = s.waterV;
+		s.causticsGridOffset = uniformRingWrite(s.uniforms, &grid, sizeof(grid));
+	}
+	uniformRingCommit(s.uniforms);
+	glBindBufferRange(GL_UNIFORM_BUFFER, PER_FRAME_BINDING, s.uniforms.buffer, frameOffset, sizeof(PerFrame));
+
+	executeFrameGraph(s.graph, s.profiler);
+
+	profilerFrameEnd(s.profiler);
+	endFrame(s.pacer);
+}
@@ -0,0 +1,289 @@
+#include <shaders.h>
+#include <glextra.h>
+#include <log.h>
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <sstream>
+#include <map>
+#include <vector>
+
+ShaderCacheStats shaderCacheStats;
+static std::map<std::string, GLuint> programs;	// every program built so far, keyed by its files and defines
+
+static std::string readShader(const std::string & path) {
+	std::string code;
+	std::ifstream file;
+	// ensure ifstream objects can throw exceptions:
+	file.exceptions(std::ifstream::failbit | std::ifstream::badbit);
+	try {
+		file.open(path);
+		std::stringstream stream;
+		stream << file.rdbuf();
+		file.close();
+		code = stream.str();
+	}
+	catch (std::ifstream::failure e) {
+		logMessage(LOG_ERROR, "ERROR::SHADER::FILE_NOT_SUCCESFULLY_READ %s", path.c_str());
+	}
+	return code;
+}
+
+static void expandShader(const std::string & path, const std::vector<std::string> & defines, std::vector<std::string> & included, int depth, std::string & out) {
+	/*
+	Appends the file to out, replacing each #include "name" line (relative to the file's directory) with that
+	file, once per stage, and following the #version line with the defines. #line directives keep compile
+	errors pointing at the right line of each file
+	*/
+	if (depth > SHADER_INCLUDE_DEPTH) {
+		logMessage(LOG_ERROR, "ERROR::SHADER::INCLUDE_TOO_DEEP %s", path.c_str());
+		return;
+	}
+	size_t slash = path.find_last_of("/\\");
+	std::string dir = slash == std::string::npos ? "" : path.substr(0, slash);
+	std::istringstream code(readShader(path));
+	std::string line;
+	for (int number = 1; std::getline(code, line); number++) {
+		size_t start = line.find_first_not_of(" \t");
+		if (start != std::string::npos && line.compare(start, 8, "#include") == 0) {
+			size_t open = line.find('"', start), close = line.rfind('"');
+			if (open == std::string::npos || close <= open) {
+				logMessage(LOG_ERROR, "ERROR::SHADER::BAD_INCLUDE %s:%d", path.c_str(), number);
+				continue;
+			}
+			std::string name = (dir.empty() ? "" : dir + "/") + line.substr(open + 1, close - open - 1);
+			if (std::find(included.begin(), included.end(), name) == included.end()) {
+				included.push_back(name);
+				out += "#line 1\n";
+				expandShader(name, defines, included, depth + 1, out);
+				out += "#line " + std::to_string(number + 1) + "\n";
+			}
+			continue;
+		}
+		out += line + "\n";
+		if (depth == 0 && start != std::string::npos && line.compare(start, 8, "#version") == 0) {
+			for (const std::string & define : defines) {
+				out += "#define " + define + "\n";
+			}
+			out += "#line " + std::to_string(number + 1) + "\n";
+		}
+	}
+}
+
+static std::string preprocessShader(const GLchar * path, const std::vector<std::string> & defines) {
+	std::vector<std::string> included;
+	std::string out;
+	expandShader(path, defines, included, 0, out);
+	return out;
+}
+
+static uint64_t hashProgram(const GLenum * stages, const std::string * sources, int count) {
+	/*
+	FNV-1a over the driver strings and every stage's type and source, so a new driver or an edited shader misses the cache
+	*/
+	uint64_t h = 14695981039346656037ull;
+	auto mix = [&h](const void * data, size_t size) {
+		for (size_t i = 0; i < size; i++) {
+			h = (h ^ ((const unsigned char *)data)[i]) * 1099511628211ull;
+		}
+	};
+	const GLenum strings[] = { GL_VENDOR, GL_RENDERER, GL_VERSION };
+	for (GLenum name : strings) {
+		const char * str = (const char *)glGetString(name);
+		mix(str, strlen(str) + 1);
+	}
+	for (int i = 0; i < count; i++) {
+		mix(&stages[i], sizeof(GLenum));
+		mix(sources[i].c_str(), sources[i].size() + 1);
+	}
+	return h;
+}
+
+struct ProgramCacheHeader {
+	char magic[4];
+	uint64_t key;
+	GLenum format;
+	GLint length;
+};
+
+static std::string cachePath(uint64_t key) {
+	char name[32];
+	snprintf(name, sizeof(name), "%016llx.bin", (unsigned long long)key);
+	return std::string(SHADER_CACHE_DIR) + "/" + name;
+}
+
+static bool loadCachedProgram(GLuint program, uint64_t key) {
+	std::ifstream file(cachePath(key), std::ios::binary);
+	ProgramCacheHeader header;
+	if (!file.read((char *)&header, sizeof(header)) || memcmp(header.magic, "OPB1", 4) != 0 || header.key != key || header.length <= 0) {
+		return false;
+	}
+	std::vector<char> binary(header.length);
+	if (!file.read(binary.data(), header.length)) {
+		return false;
+	}
+
+	// a driver update can reject its own older binaries; that only costs a normal compile
+	glProgramBinary(program, header.format, binary.data(), header.length);
+	GLint linked = GL_FALSE;
+	glGetProgramiv(program, GL_LINK_STATUS, &linked);
+	return linked == GL_TRUE;
+}
+
+static void storeCachedProgram(GLuint program, uint64_t key) {
+	ProgramCacheHeader header = { { 'O', 'P', 'B', '1' }, key, 0, 0 };
+	glGetProgramiv(program, GL_PROGRAM_BINARY_LENGTH, &header.length);
+	if (header.length <= 0) {
+		return;
+	}
+	std::vector<char> binary(header.length);
+	glGetProgramBinary(program, header.length, &header.length, &header.format, binary.data());
+
+	std::error_code error;
+	std::filesystem::create_directories(SHADER_CACHE_DIR, error);
+	std::ofstream file(cachePath(key), std::ios::binary | std::ios::trunc);
+	file.write((const char *)&header, sizeof(header));
+	file.write(binary.data(), header.length);
+}
+
+static GLuint buildProgram(const GLenum * stages, const std::string * sources, const char * const * names, int count) {
+	/*
+	Links a program from the given stages, from the binary cache if it has this exact program for this driver
+	*/
+	auto start = std::chrono::steady_clock::now();
+	GLuint ID = glCreateProgram();
+	uint64_t key = 0;
+
+	bool cached = false;
+	if (glExtras.programBinary) {
+		key = hashProgram(stages, sources, count);
+		cached = loadCachedProgram(ID, key);
+	}
+
+	if (cached) {
+		shaderCacheStats.hits++;
+	}
+	else {
+		// compile shaders
+		std::vector<GLuint> shaders;
+		for (int i = 0; i < count; i++) {
+			const char * code = sources[i].c_str();
+			GLuint shader = glCreateShader(stages[i]);
+			glShaderSource(shader, 1, &code, NULL);
+			glCompileShader(shader);
+			checkForErrors(shader, names[i]);
+			glAttachShader(ID, shader);
+			shaders.push_back(shader);
+		}
+		// shader Program
+		if (glExtras.programBinary) {
+			glProgramParameteri(ID, GL_PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE);
+		}
+		glLinkProgram(ID);
+		checkForErrors(ID, "PROGRAM");
+		// delete the shaders as they're linked into our program now and no longer necessary
+		for (GLuint shader : shaders) {
+			glDetachShader(ID, shader);
+			glDeleteShader(shader);
+		}
+
+		GLint linked = GL_FALSE;
+		glGetProgramiv(ID, GL_LINK_STATUS, &linked);
+		if (glExtras.programBinary && linked) {
+			storeCachedProgram(ID, key);
+		}
+		shaderCacheStats.misses++;
+	}
+
+	shaderCacheStats.ms += std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+	return ID;
+}
+
+static GLuint loadProgram(const GLenum * stages, const GLchar * const * files, const char * const * names, int count, const std::vector<std::string> & defines) {
+	/*
+	Returns the program already built from these files and defines, or preprocesses and builds it
+	*/
+	std::string key;
+	for (int i = 0; i < count; i++) {
+		key += std::string(files[i]) + "|";
+	}
+	for (const std::string & define : defines) {
+		key += define + "|";
+	}
+	auto found = programs.find(key);
+	if (found != programs.end()) {
+		shaderCacheStats.reused++;
+		return found->second;
+	}
+
+	std::vector<std::string> sources;
+	for (int i = 0; i < count; i++) {
+		sources.push_back(preprocessShader(files[i], defines));
+	}
+	GLuint ID = buildProgram(stages, sources.data(), names, count);
+	programs[key] = ID;
+	return ID;
+}
+
+GLuint loadProgram(const GLchar* vsh, const GLchar* fsh, const std::vector<std::string> & defines) {
+	/*
+	Loads a shader program. Takes 2 strings as arguments: file name of vertex shader, file name of fragment shader
+	*/
+	const GLenum stages[] = { GL_VERTEX_SHADER, GL_FRAGMENT_SHADER };
+	const GLchar * const files[] = { vsh, fsh };
+	const char * const names[] = { "VERTEX", "FRAGMENT" };
+	return loadProgram(stages, files, names, 2, defines);
+}
+
+GLuint loadProgram(const GLchar* vsh, const GLchar* gsh, const GLchar* fsh, const std::vector<std::string> & defines) {
+	/*
+	Loads a shader program. Takes 3 strings as arguments: file names of the vertex, geometry and fragment shaders
+	*/
+	const GLenum stages[] = { GL_VERTEX_SHADER, GL_GEOMETRY_SHADER, GL_FRAGMENT_SHADER };
+	const GLchar * const files[] = { vsh, gsh, fsh };
+	const char * const names[] = { "VERTEX", "GEOMETRY", "FRAGMENT" };
+	return loadProgram(stages, files, names, 3, defines);
+}
+
+GLuint loadTessProgram(const GLchar* vsh, const GLchar* tcs, const GLchar* tes, const GLchar* fsh, const std::vector<std::string> & defines) {
+	/*
+	Loads a tessellated program from the files of its four stages
+	*/
+	const GLenum stages[] = { GL_VERTEX_SHADER, GL_TESS_CONTROL_SHADER, GL_TESS_EVALUATION_SHADER, GL_FRAGMENT_SHADER };
+	const GLchar * const files[] = { vsh, tcs, tes, fsh };
+	const char * const names[] = { "VERTEX", "TESS_CONTROL", "TESS_EVALUATION", "FRAGMENT" };
+	return loadProgram(stages, files, names, 4, defines);
+}
+
+GLuint loadComputeProgram(const GLchar* csh, const std::vector<std::string> & defines) {
+	/*
+	Loads a compute program from one file; only call when glExtras.compute is set
+	*/
+	const GLenum stages[] = { GL_COMPUTE_SHADER };
+	const GLchar * const files[] = { csh };
+	const char * const names[] = { "COMPUTE" };
+	return loadProgram(stages, files, names, 1, defines);
+}
+
+void checkForErrors(unsigned int shader, std::string type) {
+	int success;
+	char infoLog[1024];
+	if (type != "PROGRAM") { // link errors
+		glGetShaderiv(shader, GL_COMPILE_STATUS, &success);
+		if (!success) {
+			glGetShaderInfoLog(shader, 1024, NULL, infoLog);
+			logMessage(LOG_ERROR, "ERROR::SHADER_COMPILATION_ERROR of type: %s\n%s\n -- --------------------------------------------------- -- ", type.c_str(), infoLog);
+		}
+	}
+	else { // shader compile errors
+		glGetProgramiv(shader, GL_LINK_STATUS, &success);
+		if (!success) {
+			glGetProgramInfoLog(shader, 1024, NULL, infoLog);
+			logMessage(LOG_ERROR, "ERROR::PROGRAM_LINKING_ERROR of type: %s\n%s\n -- --------------------------------------------------- -- ", type.c_str(), infoLog);
+		}
+	}
+}
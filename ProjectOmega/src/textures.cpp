@@ -0,0 +1,156 @@
+#define STB_IMAGE_IMPLEMENTATION
+#include <textures.h>
+#include <log.h>
+#include <glm/glm.hpp>
+#include <atomic>
+#include <cstring>
+#include <thread>
+
+struct PendingImage {
+	const TextureLoad * load;
+	GLenum target;				// GL_TEXTURE_2D or a cubemap face
+	const std::string * file;
+	int width, height, channels;	// channels actually stored (3 or 4)
+	size_t offset;				// into the staging buffer
+	bool ok;
+};
+
+void loadTextures(const std::vector<TextureLoad> & loads, unsigned threads) {
+	/*
+	Loads 2D textures and cubemaps in one go
+	The image headers are read first so every image gets its slice of a single GL_PIXEL_UNPACK_BUFFER;
+	the workers then decode in parallel while this thread waits, each copying its pixels from stb's buffer
+	into the mapped one, and the uploads are plain copies out of the buffer, one glTexImage2D per image.
+	A texture with an image that did not load gets a 1x1 placeholder texel, so it is still complete
+	threads -> number of decode workers (0 = one per hardware thread)
+	*/
+	std::vector<PendingImage> images;
+	size_t total = 0;
+	for (const TextureLoad & l : loads) {
+		for (size_t i = 0; i < l.files.size(); i++) {
+			GLenum target = l.target == GL_TEXTURE_CUBE_MAP ? GLenum(GL_TEXTURE_CUBE_MAP_POSITIVE_X + i) : l.target;
+			PendingImage img = { &l, target, &l.files[i], 0, 0, 0, total, false };
+			int n;
+			if (stbi_info(l.files[i].c_str(), &img.width, &img.height, &n)) {
+				img.channels = n == 4 && l.target != GL_TEXTURE_CUBE_MAP ? 4 : 3;
+				total += (size_t(img.width) * img.height * img.channels + 3) & ~size_t(3);
+			}
+			images.push_back(img);
+		}
+	}
+
+	GLuint pbo;
+	glGenBuffers(1, &pbo);
+	glBindBuffer(GL_PIXEL_UNPACK_BUFFER, pbo);
+	glBufferData(GL_PIXEL_UNPACK_BUFFER, glm::max(total, size_t(1)), NULL, GL_STREAM_DRAW);
+	unsigned char * staging = (unsigned char *)glMapBufferRange(GL_PIXEL_UNPACK_BUFFER, 0, glm::max(total, size_t(1)), GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_BUFFER_BIT);
+
+	if (threads == 0) {
+		threads = glm::max(std::thread::hardware_concurrency(), 1u);
+	}
+	threads = glm::min(threads, unsigned(images.size()));
+	std::atomic<size_t> next(0);
+	auto worker = [&]() {
+		for (size_t i = next++; i < images.size(); i = next++) {
+			PendingImage & img = images[i];
+			if (img.width == 0 || !staging) {
+				continue;
+			}
+			int w, h, n;
+			unsigned char * data = stbi_load(img.file->c_str(), &w, &h, &n, img.channels);
+			if (data && w == img.width && h == img.height) {
+				memcpy(staging + img.offset, data, size_t(w) * h * img.channels);
+				img.ok = true;
+			}
+			stbi_image_free(data);
+		}
+	};
+	std::vector<std::thread> pool;
+	for (unsigned t = 1; t < threads; t++) {
+		pool.emplace_back(worker);
+	}
+	worker();
+	for (std::thread & t : pool) {
+		t.join();
+	}
+	glUnmapBuffer(GL_PIXEL_UNPACK_BUFFER);
+
+	glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+	bool missing = false;		// an image of the current texture did not load
+	for (size_t i = 0; i < images.size(); i++) {
+		PendingImage & img = images[i];
+		const TextureLoad & l = *img.load;
+		GLenum format = img.channels == 4 ? GL_RGBA : GL_RGB;
+
+		if (i == 0 || images[i - 1].load != img.load) {
+			glGenTextures(1, l.tex);
+			glActiveTexture(GL_TEXTURE0 + l.texUnit);
+			glBindTexture(l.target, *l.tex);
+			missing = false;
+		}
+
+		if (img.ok) {
+			glTexImage2D(img.target, 0, format, img.width, img.height, 0, format, GL_UNSIGNED_BYTE, (void *)img.offset);
+		}
+		else if (l.target == GL_TEXTURE_CUBE_MAP) {
+			logMessage(LOG_ERROR, "Cubemap texture failed to load at path: %s", img.file->c_str());
+			missing = true;
+		}
+		else {
+			logMessage(LOG_ERROR, "Failed to load texture %s", img.file->c_str());
+			missing = true;
+		}
+
+		// last image of this texture: sampling state
+		if (i + 1 == images.size() || images[i + 1].load != img.load) {
+			if (missing) {
+				// magenta, and every face of a cubemap the same size; from client memory, not the staging buffer
+				static const unsigned char placeholder[3] = { 255, 0, 255 };
+				glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+				for (GLuint face = 0; face < (l.target == GL_TEXTURE_CUBE_MAP ? 6u : 1u); face++) {
+					GLenum target = l.target == GL_TEXTURE_CUBE_MAP ? GL_TEXTURE_CUBE_MAP_POSITIVE_X + face : l.target;
+					glTexImage2D(target, 0, GL_RGB, 1, 1, 0, GL_RGB, GL_UNSIGNED_BYTE, placeholder);
+				}
+				glBindBuffer(GL_PIXEL_UNPACK_BUFFER, pbo);
+			}
+			if (l.target == GL_TEXTURE_CUBE_MAP) {
+				glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+				glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+				glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+				glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+				glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_R, GL_CLAMP_TO_EDGE);
+			}
+			else {
+				glTexParameteri(l.target, GL_TEXTURE_WRAP_S, GL_REPEAT);
+				glTexParameteri(l.target, GL_TEXTURE_WRAP_T, GL_REPEAT);
+				glTexParameteri(l.target, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+				glTexParameteri(l.target, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+				if (!missing) {
+					glGenerateMipmap(l.target);
+				}
+			}
+		}
+	}
+	glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+	glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+	glDeleteBuffers(1, &pbo);
+}
+
+void loadTexture(GLuint * tex, GLuint texUnit, const GLchar * fileName) {
+	/*
+	Loads 2D textures
+	tex -> GLuint where to store the texture
+	texUnit -> which texture unit to load the texture into
+	fileName -> file name of image to load
+	*/
+	loadTextures({ TextureLoad{ tex, texUnit, GL_TEXTURE_2D, { fileName } } }, 1);
+}
+
+GLuint loadCubemap(std::vector<std::string> f) {
+	/*
+	Loads the six faces of a cubemap (+x, -x, +y, -y, +z, -z) into texture unit 0
+	*/
+	GLuint texID;
+	loadTextures({ TextureLoad{ &texID, 0, GL_TEXTURE_CUBE_MAP, f } }, 1);
+	return texID;
+}
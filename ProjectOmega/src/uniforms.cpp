@@ -0,0 +1,68 @@
+#include <uniforms.h>
+#include <glextra.h>
+#include <algorithm>
+#include <assert.h>
+#include <cstring>
+
+void setupUniformRing(UniformRing & r) {
+	glGetIntegerv(GL_UNIFORM_BUFFER_OFFSET_ALIGNMENT, &r.align);
+	GLsizeiptr block = (std::max(sizeof(PerFrame), sizeof(PerDraw)) + r.align - 1) / r.align * r.align;
+	r.sliceSize = block * UNIFORM_RING_BLOCKS;
+	GLsizeiptr total = r.sliceSize * UNIFORM_RING_FRAMES;
+
+	glGenBuffers(1, &r.buffer);
+	glBindBuffer(GL_UNIFORM_BUFFER, r.buffer);
+	r.persistent = glExtras.bufferStorage;
+	if (r.persistent) {
+		GLbitfield flags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+		glBufferStorage(GL_UNIFORM_BUFFER, total, NULL, flags);
+		r.mapped = (unsigned char *)glMapBufferRange(GL_UNIFORM_BUFFER, 0, total, flags);
+		r.persistent = r.mapped != NULL;
+	}
+	if (!r.persistent) {
+		glBufferData(GL_UNIFORM_BUFFER, total, NULL, GL_DYNAMIC_DRAW);
+	}
+	glBindBuffer(GL_UNIFORM_BUFFER, 0);
+}
+
+void uniformRingBegin(UniformRing & r, int slice) {
+	r.slice = slice;
+	r.used = 0;
+	if (!r.persistent) {
+		// the pacer's fence already covers the GPU side, so the driver need not synchronize the mapping
+		glBindBuffer(GL_UNIFORM_BUFFER, r.buffer);
+		r.mapped = (unsigned char *)glMapBufferRange(GL_UNIFORM_BUFFER, r.slice * r.sliceSize, r.sliceSize,
+			GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_RANGE_BIT | GL_MAP_UNSYNCHRONIZED_BIT);
+	}
+}
+
+GLintptr uniformRingWrite(UniformRing & r, const void * data, GLsizeiptr size) {
+	assert(r.used + size <= r.sliceSize && "more than UNIFORM_RING_BLOCKS blocks in a frame");
+	GLintptr offset = r.slice * r.sliceSize + r.used;
+	memcpy(r.mapped + (r.persistent ? offset : r.used), data, size);
+	r.used += (size + r.align - 1) / r.align * r.align;
+	return offset;
+}
+
+void uniformRingCommit(UniformRing & r) {
+	if (!r.persistent) {
+		glBindBuffer(GL_UNIFORM_BUFFER, r.buffer);
+		glUnmapBuffer(GL_UNIFORM_BUFFER);
+		r.mapped = NULL;
+	}
+}
+
+void bindUniformBlocks(GLuint program) {
+	GLuint frame = glGetUniformBlockIndex(program, "PerFrame");
+	if (frame != GL_INVALID_INDEX) {
+		glUniformBlockBinding(program, frame, PER_FRAME_BINDING);
+	}
+	GLuint draw = glGetUniformBlockIndex(program, "PerDraw");
+	if (draw != GL_INVALID_INDEX) {
+		glUniformBlockBinding(program, draw, PER_DRAW_BINDING);
+	}
+	GLuint grid = glGetUniformBlockIndex(program, "WaterGrid");
+	if (grid != GL_INVALID_INDEX) {
+		glUniformBlockBinding(program, grid, WATER_GRID_BINDING);
+	}
+}
@@ -0,0 +1,112 @@
+#include <waterlod.h>
+#include <glstate.h>
+#include <algorithm>
+#include <cstring>
+
+void setupWaterLod(WaterLod & l) {
+	releaseWaterLod(l);
+	glGenVertexArrays(1, &l.vao);
+	glBindVertexArray(l.vao);
+	glGenBuffers(1, &l.buffer);
+	glBindBuffer(GL_ARRAY_BUFFER, l.buffer);
+	glBufferData(GL_ARRAY_BUFFER, FRAME_CONTEXTS_MAX * WATER_LOD_NODES_MAX * sizeof(glm::vec4), NULL, GL_STREAM_DRAW);
+	glEnableVertexAttribArray(0);
+	glVertexAttribDivisor(0, 1);
+	glBindBuffer(GL_ARRAY_BUFFER, 0);
+	invalidateGLState();
+	l.nodes.reserve(WATER_LOD_NODES_MAX);
+	l.skipped = 0;
+}
+
+void releaseWaterLod(WaterLod & l) {
+	if (l.vao) glDeleteVertexArrays(1, &l.vao);
+	if (l.buffer) glDeleteBuffers(1, &l.buffer);
+	l.vao = l.buffer = 0;
+	l.nodes.clear();
+	invalidateGLState();
+}
+
+struct WaterLodSelection {
+	glm::vec3 eye, origin, u, v;
+	GLfloat uu, vv;		// squared lengths of u and v
+	int leaves;
+};
+
+static GLfloat nodeDistance(const WaterLodSelection & s, glm::vec2 corner, GLfloat size) {
+	// to the nearest point of the node, u and v being perpendicular
+	glm::vec3 e = s.eye - s.origin;
+	glm::vec2 at = glm::clamp(glm::vec2(glm::dot(e, s.u) / s.uu, glm::dot(e, s.v) / s.vv), corner, corner + size);
+	return glm::length(e - s.u * at.x - s.v * at.y);
+}
+
+static void selectNode(WaterLod & l, WaterLodSelection & s, glm::vec2 corner, GLfloat size, int depth, GLfloat range) {
+	if (nodeDistance(s, corner, size) < range && depth < WATER_LOD_DEPTH) {
+		if (s.leaves + 3 <= WATER_LOD_NODES_MAX) {
+			s.leaves += 3;
+			GLfloat half = size * .5f;
+			for (int i = 0; i < 4; i++) {
+				selectNode(l, s, corner + half * glm::vec2(i & 1, i >> 1), half, depth + 1, range * .5f);
+			}
+			return;
+		}
+		l.skipped++;
+	}
+	// the parent's grid is as fine as needed from twice the range
+	l.nodes.push_back(glm::vec4(corner, size, 2.f * range));
+	l.depth = std::max(l.depth, depth);
+}
+
+void selectWaterLod(WaterLod & l, glm::vec3 eye, glm::vec3 origin, glm::vec3 u, glm::vec3 v, GLfloat lod) {
+	/*
+	A node of side L is fine enough from where its spacing L / WATER_LOD_NODE times lod over the distance
+	is one target spacing. While morphing a node is up to twice as coarse, so the range leaves room for
+	that: its parent's grid is fine enough only from twice the range, where the morph ends
+	*/
+	WaterLodSelection s;
+	s.eye = eye;
+	s.origin = origin;
+	s.u = u;
+	s.v = v;
+	s.uu = glm::dot(u, u);
+	s.vv = glm::dot(v, v);
+	GLfloat side = sqrt(glm::max(s.uu, s.vv));
+	GLfloat range = glm::max(side / WATER_LOD_NODE * lod / (1.f - WATER_LOD_MORPH), WATER_LOD_MIN_RANGE * side);
+	s.leaves = 1;
+	l.nodes.clear();
+	l.depth = 0;
+	selectNode(l, s, glm::vec2(0.f), 1.f, 0, range);
+}
+
+void uploadWaterLod(WaterLod & l, int context) {
+	// the pacer has waited for the frame that last used this slice, so the mapping need not synchronize
+	GLsizeiptr slice = WATER_LOD_NODES_MAX * sizeof(glm::vec4);
+	l.offset = context * slice;
+	glBindBuffer(GL_ARRAY_BUFFER, l.buffer);
+	void * mapped = glMapBufferRange(GL_ARRAY_BUFFER, l.offset, slice, GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_RANGE_BIT | GL_MAP_UNSYNCHRONIZED_BIT);
+	if (mapped) {
+		memcpy(mapped, l.nodes.data(), l.nodes.size() * sizeof(glm::vec4));
+		glUnmapBuffer(GL_ARRAY_BUFFER);
+	}
+	glBindBuffer(GL_ARRAY_BUFFER, 0);
+}
+
+void drawWaterLod(const WaterLod & l) {
+	// a strip per node, its rows joined by two repeated vertices
+	bindVertexArray(l.vao);
+	glBindBuffer(GL_ARRAY_BUFFER, l.buffer);
+	glVertexAttribPointer(0, 4, GL_FLOAT, GL_FALSE, 0, (void *)l.offset);
+	glBindBuffer(GL_ARRAY_BUFFER, 0);
+	glDrawArraysInstanced(GL_TRIANGLE_STRIP, 0, WATER_LOD_NODE * (2 * WATER_LOD_NODE + 4), GLsizei(l.nodes.size()));
+}
+
+GLuint waterLodResolution(glm::vec3 eye, glm::vec3 origin, glm::vec3 u, glm::vec3 v, GLfloat lod) {
+	WaterLodSelection s;
+	s.eye = eye;
+	s.origin = origin;
+	s.u = u;
+	s.v = v;
+	s.uu = glm::dot(u, u);
+	s.vv = glm::dot(v, v);
+	GLfloat nearest = glm::max(nodeDistance(s, glm::vec2(0.f), 1.f), 1e-4f);
+	return GLuint(ceil(sqrt(glm::max(s.uu, s.vv)) * lod / nearest));
+}
@@ -0,0 +1,164 @@
+#include <watersim.h>
+#include <glstate.h>
+#include <log.h>
+#include <shaders.h>
+#include <cmath>
+
+static void makeTarget(GLuint * fbo, GLuint * tex, GLsizei size) {
+	glGenFramebuffers(1, fbo);
+	glGenTextures(1, tex);
+	glBindFramebuffer(GL_FRAMEBUFFER, *fbo);
+	glBindTexture(GL_TEXTURE_2D, *tex);
+	glTexImage2D(GL_TEXTURE_2D, 0, GL_RG32F, size, size, 0, GL_RG, GL_FLOAT, 0);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);	// the water's vertices fall between texels
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+	glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, *tex, 0);
+
+	auto status = glCheckFramebufferStatus(GL_FRAMEBUFFER);
+	if (status != GL_FRAMEBUFFER_COMPLETE) {
+		logMessage(LOG_ERROR, "Cannot setup water simulation framebuffer (incomplete): %u.", status);
+	}
+	// at rest
+	glClearColor(0.f, 0.f, 0.f, 0.f);
+	glClear(GL_COLOR_BUFFER_BIT);
+}
+
+void releaseWaterSim(WaterSim & w) {
+	for (int i = 0; i < 2; i++) {
+		if (w.fbo[i]) glDeleteFramebuffers(1, &w.fbo[i]);
+		if (w.tex[i]) glDeleteTextures(1, &w.tex[i]);
+		w.fbo[i] = w.tex[i] = 0;
+	}
+	w.output = 0;
+}
+
+void setupWaterSim(WaterSim & w, GLsizei size, glm::vec2 origin, glm::vec2 extent) {
+	/*
+	(Re)allocates the heightfield at rest and derives the step: a wave crosses WATER_SIM_COURANT texels per
+	step at WATER_SIM_SPEED, and the damping takes WATER_SIM_DECAY seconds whatever the step rate
+	*/
+	releaseWaterSim(w);
+	w.size = glm::clamp(size, 2, WATER_SIM_SIZE_MAX);
+	w.origin = origin;
+	w.extent = extent;
+	GLfloat texel = glm::max(extent.x, extent.y) / w.size;
+	w.rate = WATER_SIM_SPEED / (WATER_SIM_COURANT * texel);
+	w.damping = exp(-1.f / (w.rate * WATER_SIM_DECAY));
+
+	glActiveTexture(GL_TEXTURE0 + WATER_SIM_UNIT);
+	for (int i = 0; i < 2; i++) {
+		makeTarget(&w.fbo[i], &w.tex[i], w.size);
+	}
+	w.current = 0;
+	w.output = w.tex[0];
+	w.time = -1.0;
+	w.drops.clear();
+	for (WaterObject & o : w.objects) {
+		o.placed = false;
+	}
+	w.steps = 0;
+	w.totalSteps = w.skippedSteps = 0;
+
+	if (!w.stepprogram) {
+		w.stepprogram = loadProgram("shaders/frame.vsh", "shaders/watersim.fsh");
+		w.w_state = glGetUniformLocation(w.stepprogram, "state");
+		w.w_wave = glGetUniformLocation(w.stepprogram, "wave");
+		w.w_damping = glGetUniformLocation(w.stepprogram, "damping");
+		w.w_drops = glGetUniformLocation(w.stepprogram, "drops");
+		w.w_drop = glGetUniformLocation(w.stepprogram, "drop");
+	}
+	glUseProgram(w.stepprogram);
+	glUniform1i(w.w_state, WATER_SIM_UNIT);
+	glUniform1f(w.w_wave, WATER_SIM_COURANT * WATER_SIM_COURANT);
+	glUniform1f(w.w_damping, w.damping);
+	invalidateGLState();
+}
+
+void addWaterDrop(WaterSim & w, glm::vec2 pos, GLfloat radius, GLfloat height) {
+	w.drops.push_back({ pos, radius, height });
+}
+
+int addWaterObject(WaterSim & w, GLfloat radius, GLfloat depth) {
+	WaterObject o;
+	o.radius = radius;
+	o.depth = depth;
+	w.objects.push_back(o);
+	return int(w.objects.size()) - 1;
+}
+
+void moveWaterObject(WaterSim & w, int object, glm::vec2 pos) {
+	WaterObject & o = w.objects[object];
+	if (!o.placed) {
+		o.from = pos;
+	}
+	o.pos = pos;
+}
+
+static glm::vec4 texelDrop(const WaterSim & w, glm::vec2 pos, GLfloat radius, GLfloat height) {
+	// x, y and radius in texels, at least one so a small drop still lands on a texel
+	glm::vec2 p = (pos - w.origin) / w.extent * GLfloat(w.size);
+	return glm::vec4(p, glm::max(radius / glm::max(w.extent.x, w.extent.y) * w.size, 1.f), height);
+}
+
+void runWaterSim(WaterSim & w, GLfloat time, GLuint screenVAO) {
+	/*
+	Runs the whole steps between the simulated time and time, each applying the drops that fit and the
+	objects' displacement between where they were and where they are a step later. Leaves the viewport
+	at the heightfield size
+	*/
+	w.steps = 0;
+	if (w.time < 0.0 || time < w.time) {
+		w.time = time;
+	}
+	int steps = int(floor((time - w.time) * w.rate));
+	if (steps > WATER_SIM_MAX_STEPS) {
+		// a stall (or a long time the water was not drawn) is skipped rather than caught up in one frame
+		w.skippedSteps += steps - WATER_SIM_MAX_STEPS;
+		w.time = time - WATER_SIM_MAX_STEPS / double(w.rate);
+		steps = WATER_SIM_MAX_STEPS;
+	}
+	if (steps <= 0) {
+		bindTexture(WATER_SIM_UNIT, GL_TEXTURE_2D, w.output);
+		return;
+	}
+
+	bindVertexArray(screenVAO);
+	useProgram(w.stepprogram);
+	setViewport(0, 0, w.size, w.size);
+	size_t queued = 0;
+	for (int i = 0; i < steps; i++) {
+		glm::vec4 drops[WATER_SIM_DROPS];
+		int n = 0;
+		for (WaterObject & o : w.objects) {
+			if (o.placed && o.pos == o.from) continue;		// standing still makes no waves
+			if (n + 2 > WATER_SIM_DROPS) break;
+			if (o.placed) {
+				drops[n++] = texelDrop(w, glm::mix(o.from, o.pos, GLfloat(i) / steps), o.radius, o.depth);
+			}
+			drops[n++] = texelDrop(w, glm::mix(o.from, o.pos, GLfloat(i + 1) / steps), o.radius, -o.depth);
+			o.placed = true;
+		}
+		for (; n < WATER_SIM_DROPS && queued < w.drops.size(); queued++) {
+			drops[n++] = texelDrop(w, w.drops[queued].pos, w.drops[queued].radius, w.drops[queued].height);
+		}
+		glUniform1i(w.w_drops, n);
+		if (n) glUniform4fv(w.w_drop, n, &drops[0].x);
+
+		bindTexture(WATER_SIM_UNIT, GL_TEXTURE_2D, w.tex[w.current]);
+		w.current ^= 1;
+		bindFramebuffer(w.fbo[w.current]);
+		glDrawArrays(GL_TRIANGLE_STRIP, 0, 4);
+	}
+	w.drops.erase(w.drops.begin(), w.drops.begin() + queued);
+	for (WaterObject & o : w.objects) {
+		o.from = o.pos;
+	}
+
+	w.output = w.tex[w.current];
+	bindTexture(WATER_SIM_UNIT, GL_TEXTURE_2D, w.output);
+	w.time += steps / double(w.rate);
+	w.steps = steps;
+	w.totalSteps += steps;
+}
@@ -0,0 +1,74 @@
+#include <workers.h>
+#include <algorithm>
+
+static void runChunks(WorkerPool & p) {
+	for (int begin = p.next.fetch_add(p.chunk); begin < p.count; begin = p.next.fetch_add(p.chunk)) {
+		(*p.job)(begin, std::min(begin + p.chunk, p.count));
+	}
+}
+
+static void workerLoop(WorkerPool & p) {
+	unsigned seen = 0;
+	for (;;) {
+		{
+			std::unique_lock<std::mutex> lock(p.mutex);
+			p.wake.wait(lock, [&] { return p.quit || p.generation != seen; });
+			if (p.quit) {
+				return;
+			}
+			seen = p.generation;
+		}
+		runChunks(p);
+		std::lock_guard<std::mutex> lock(p.mutex);
+		if (--p.busy == 0) {
+			p.done.notify_one();
+		}
+	}
+}
+
+void setupWorkerPool(WorkerPool & p, unsigned threads) {
+	releaseWorkerPool(p);
+	if (threads == 0) {
+		threads = std::max(std::thread::hardware_concurrency(), 1u) - 1;
+	}
+	p.quit = false;
+	for (unsigned t = 0; t < threads; t++) {
+		p.threads.emplace_back(workerLoop, std::ref(p));
+	}
+}
+
+void releaseWorkerPool(WorkerPool & p) {
+	{
+		std::lock_guard<std::mutex> lock(p.mutex);
+		p.quit = true;
+	}
+	p.wake.notify_all();
+	for (std::thread & t : p.threads) {
+		t.join();
+	}
+	p.threads.clear();
+}
+
+WorkerPool::~WorkerPool() {
+	releaseWorkerPool(*this);
+}
+
+void parallelFor(WorkerPool & p, int count, int chunk, const std::function<void(int, int)> & body) {
+	p.job = &body;
+	p.count = count;
+	p.chunk = std::max(chunk, 1);
+	p.next = 0;
+	if (p.threads.empty() || count <= p.chunk) {
+		runChunks(p);
+		return;
+	}
+	{
+		std::lock_guard<std::mutex> lock(p.mutex);
+		p.busy = int(p.threads.size());
+		p.generation++;
+	}
+	p.wake.notify_all();
+	runChunks(p);
+	std::unique_lock<std::mutex> lock(p.mutex);
+	p.done.wait(lock, [&] { return p.busy == 0; });
+}